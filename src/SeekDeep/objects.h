@@ -32,5 +32,15 @@
 #include "SeekDeep/objects/PrimersAndMids.hpp"
 #include "SeekDeep/objects/ReadPairsOrganizer.hpp"
 #include "SeekDeep/objects/PairedReadProcessor.hpp"
+#include "SeekDeep/objects/CmdJobScheduler.hpp"
+#include "SeekDeep/objects/TwoBitPrimerSearcher.hpp"
+#include "SeekDeep/objects/ClusterSortOrder.hpp"
+#include "SeekDeep/objects/BitParallelEditDistance.hpp"
+#include "SeekDeep/objects/ParallelCollapser.hpp"
+#include "SeekDeep/objects/StreamingIdenticalCollapser.hpp"
+#include "SeekDeep/objects/AlnCacheArchive.hpp"
 
 
+#include "SeekDeep/objects/RunPhaseProfiler.hpp"
+#include "SeekDeep/objects/SnapshotWriter.hpp"
+#include "SeekDeep/objects/BinarySeqContainer.hpp"
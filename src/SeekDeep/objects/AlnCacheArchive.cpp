@@ -0,0 +1,539 @@
+/*
+ * AlnCacheArchive.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "AlnCacheArchive.hpp"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace bibseq {
+
+namespace {
+
+const std::string indexMagic = "SDACIDX1";
+const std::string segmentMagic = "SDACSEG1";
+
+/**@brief Hold a flock on a file for the life of the object
+ *
+ */
+class ArchiveFileLock {
+public:
+	ArchiveFileLock(const bfs::path & fnp, bool exclusive) {
+		fd_ = ::open(fnp.string().c_str(), O_RDWR | O_CREAT, 0664);
+		if (fd_ < 0 || 0 != ::flock(fd_, exclusive ? LOCK_EX : LOCK_SH)) {
+			if (fd_ >= 0) {
+				::close(fd_);
+			}
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error in locking " << fnp << ", "
+					<< std::strerror(errno) << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+	}
+	~ArchiveFileLock() {
+		::flock(fd_, LOCK_UN);
+		::close(fd_);
+	}
+private:
+	int fd_;
+};
+
+/**@brief Memory map a whole file
+ *
+ */
+class ArchiveMappedFile {
+public:
+	ArchiveMappedFile(const bfs::path & fnp, bool writable) {
+		fd_ = ::open(fnp.string().c_str(), writable ? O_RDWR : O_RDONLY);
+		struct stat info;
+		if (fd_ < 0 || 0 != ::fstat(fd_, &info)) {
+			if (fd_ >= 0) {
+				::close(fd_);
+			}
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error in opening " << fnp << ", "
+					<< std::strerror(errno) << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		size_ = info.st_size;
+		if (size_ > 0) {
+			data_ = static_cast<char *>(::mmap(nullptr, size_,
+					writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0));
+			if (MAP_FAILED == data_) {
+				::close(fd_);
+				std::stringstream ss;
+				ss << __PRETTY_FUNCTION__ << ", error in mapping " << fnp << ", "
+						<< std::strerror(errno) << "\n";
+				throw std::runtime_error { ss.str() };
+			}
+		}
+	}
+	~ArchiveMappedFile() {
+		if (nullptr != data_) {
+			::munmap(data_, size_);
+		}
+		::close(fd_);
+	}
+	char * data_ { nullptr };
+	size_t size_ { 0 };
+private:
+	int fd_;
+};
+
+class ArchiveBufferReader {
+public:
+	ArchiveBufferReader(const char * start, const char * end, const bfs::path & fnp) :
+			pos_(start), end_(end), fnp_(fnp) {
+	}
+	template<typename T>
+	T read() {
+		check(sizeof(T));
+		T ret;
+		std::memcpy(&ret, pos_, sizeof(T));
+		pos_ += sizeof(T);
+		return ret;
+	}
+	std::string readStr() {
+		auto len = read<uint32_t>();
+		check(len);
+		std::string ret(pos_, len);
+		pos_ += len;
+		return ret;
+	}
+private:
+	const char * pos_;
+	const char * end_;
+	const bfs::path & fnp_;
+	void check(size_t len) const {
+		if (static_cast<size_t>(end_ - pos_) < len) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error " << fnp_ << " is truncated" << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+	}
+};
+
+template<typename T>
+void writeArchiveVal(std::ostream & out, const T & val) {
+	out.write(reinterpret_cast<const char *>(&val), sizeof(T));
+}
+
+void writeArchiveStr(std::ostream & out, const std::string & str) {
+	writeArchiveVal<uint32_t>(out, str.size());
+	out.write(str.c_str(), str.size());
+}
+
+uint64_t fnv1a(uint64_t hash, const std::string & str) {
+	for (const auto & c : str) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+	//separate the strings so moving characters between them changes the hash
+	hash ^= 0xff;
+	hash *= 1099511628211ULL;
+	return hash;
+}
+
+uint64_t mix64(uint64_t hash) {
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ULL;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebULL;
+	hash ^= hash >> 31;
+	return hash;
+}
+
+}  // namespace
+
+static_assert(sizeof(AlnCacheArchive::IndexEntry) == 32, "AlnCacheArchive::IndexEntry layout changed, the index format depends on it");
+
+bool AlnCacheArchive::Key::operator==(const Key & other) const {
+	return hash1_ == other.hash1_ && hash2_ == other.hash2_;
+}
+
+size_t AlnCacheArchive::KeyHasher::operator()(const Key & key) const {
+	return key.hash1_;
+}
+
+AlnCacheArchive::AlnCacheArchive(const bfs::path & dirName, uint64_t maxBytes) :
+		dirName_(dirName), maxBytes_(maxBytes) {
+	//several processes could be creating it at once, create_directories doesn't fail if it already exists
+	bfs::create_directories(dirName_);
+}
+
+bfs::path AlnCacheArchive::indexFnp() const {
+	return bib::files::make_path(dirName_, "index.bin");
+}
+
+bfs::path AlnCacheArchive::lockFnp() const {
+	return bib::files::make_path(dirName_, "lock");
+}
+
+bfs::path AlnCacheArchive::segmentFnp(uint32_t segment) const {
+	return bib::files::make_path(dirName_,
+			"segment_" + estd::to_string(segment) + ".bin");
+}
+
+std::vector<uint32_t> AlnCacheArchive::getSegments() const {
+	std::vector<uint32_t> ret;
+	std::regex segPat { "segment_([0-9]+)\\.bin" };
+	for (const auto & entry : bfs::directory_iterator(dirName_)) {
+		std::smatch match;
+		auto fName = entry.path().filename().string();
+		if (std::regex_match(fName, match, segPat)) {
+			ret.emplace_back(estd::stou(match[1]));
+		}
+	}
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+uint64_t AlnCacheArchive::segmentsSize() const {
+	uint64_t ret = 0;
+	for (const auto & segment : getSegments()) {
+		ret += bfs::file_size(segmentFnp(segment));
+	}
+	return ret;
+}
+
+AlnCacheArchive::Key AlnCacheArchive::genKey(const std::string & holderId,
+		const std::string & seqA, const std::string & seqB) {
+	Key ret;
+	ret.hash1_ = fnv1a(fnv1a(fnv1a(14695981039346656037ULL, holderId), seqA), seqB);
+	//second hash runs over the strings in the other order from a different start so it's independent of the first
+	ret.hash2_ = mix64(fnv1a(fnv1a(fnv1a(0x9e3779b97f4a7c15ULL, seqB), seqA), holderId));
+	return ret;
+}
+
+void AlnCacheArchive::readSegment(uint32_t segment,
+		const std::function<void(uint32_t, Record &)> & func) const {
+	auto fnp = segmentFnp(segment);
+	ArchiveMappedFile segFile(fnp, false);
+	ArchiveBufferReader reader(segFile.data_, segFile.data_ + segFile.size_, fnp);
+	for (const auto & c : segmentMagic) {
+		if (reader.read<char>() != c) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error " << fnp << " isn't an alignment cache segment" << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+	}
+	VecStr holderIds(reader.read<uint32_t>());
+	for (auto & holderId : holderIds) {
+		holderId = reader.readStr();
+	}
+	VecStr seqs(reader.read<uint32_t>());
+	for (auto & seq : seqs) {
+		seq = reader.readStr();
+	}
+	auto numRecords = reader.read<uint32_t>();
+	for (uint32_t recordPos = 0; recordPos < numRecords; ++recordPos) {
+		Record rec;
+		rec.holderId_ = holderIds.at(reader.read<uint32_t>());
+		rec.seqA_ = seqs.at(reader.read<uint32_t>());
+		rec.seqB_ = seqs.at(reader.read<uint32_t>());
+		rec.info_.score_ = reader.read<double>();
+		rec.info_.addFromFile_ = true;
+		auto numGaps = reader.read<uint32_t>();
+		for (uint32_t gapPos = 0; gapPos < numGaps; ++gapPos) {
+			auto pos = reader.read<uint32_t>();
+			auto size = reader.read<uint32_t>();
+			bool gapInA = 0 != reader.read<uint8_t>();
+			rec.info_.gapInfos_.emplace_back(gapInfo(pos, size, gapInA));
+		}
+		func(recordPos, rec);
+	}
+}
+
+void AlnCacheArchive::writeSegment(uint32_t segment,
+		const std::vector<Record> & records) const {
+	std::unordered_map<std::string, uint32_t> holderIds;
+	VecStr holderIdsOrder;
+	std::unordered_map<std::string, uint32_t> seqs;
+	std::vector<const std::string *> seqsOrder;
+	auto addSeq = [&seqs,&seqsOrder](const std::string & seq) {
+		if (seqs.emplace(seq, seqs.size()).second) {
+			seqsOrder.emplace_back(&seq);
+		}
+	};
+	for (const auto & rec : records) {
+		if (holderIds.emplace(rec.holderId_, holderIds.size()).second) {
+			holderIdsOrder.emplace_back(rec.holderId_);
+		}
+		addSeq(rec.seqA_);
+		addSeq(rec.seqB_);
+	}
+	//write to a temporary file and move it into place so a partially written segment is never seen
+	auto fnp = segmentFnp(segment);
+	auto tempFnp = bfs::path(fnp.string() + ".tmp");
+	{
+		std::ofstream out(tempFnp.string(), std::ios::binary | std::ios::trunc);
+		if (!out) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error in opening " << tempFnp << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		out.write(segmentMagic.c_str(), segmentMagic.size());
+		writeArchiveVal<uint32_t>(out, holderIdsOrder.size());
+		for (const auto & holderId : holderIdsOrder) {
+			writeArchiveStr(out, holderId);
+		}
+		writeArchiveVal<uint32_t>(out, seqsOrder.size());
+		for (const auto & seq : seqsOrder) {
+			writeArchiveStr(out, *seq);
+		}
+		writeArchiveVal<uint32_t>(out, records.size());
+		for (const auto & rec : records) {
+			writeArchiveVal<uint32_t>(out, holderIds[rec.holderId_]);
+			writeArchiveVal<uint32_t>(out, seqs[rec.seqA_]);
+			writeArchiveVal<uint32_t>(out, seqs[rec.seqB_]);
+			writeArchiveVal<double>(out, rec.info_.score_);
+			writeArchiveVal<uint32_t>(out, rec.info_.gapInfos_.size());
+			for (const auto & gap : rec.info_.gapInfos_) {
+				writeArchiveVal<uint32_t>(out, gap.pos_);
+				writeArchiveVal<uint32_t>(out, gap.size_);
+				writeArchiveVal<uint8_t>(out, gap.gapInA_ ? 1 : 0);
+			}
+		}
+		if (!out) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error in writing " << tempFnp << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+	}
+	bfs::rename(tempFnp, fnp);
+}
+
+uint64_t AlnCacheArchive::load(aligner & alignerObj,
+		const std::unordered_set<std::string> & seqs) {
+	ArchiveFileLock lock(lockFnp(), false);
+	if (!bfs::exists(indexFnp()) || 0 == bfs::file_size(indexFnp())) {
+		return 0;
+	}
+	//records listed in the index, a segment written by a process that died before adding it to the index is ignored
+	std::map<uint32_t, std::unordered_map<uint32_t, Key>> liveRecords;
+	{
+		ArchiveMappedFile index(indexFnp(), false);
+		if (index.size_ < indexMagic.size()
+				|| 0 != std::memcmp(index.data_, indexMagic.c_str(), indexMagic.size())) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error " << indexFnp() << " isn't an alignment cache index" << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		//a partially appended last entry is ignored
+		uint64_t numEntries = (index.size_ - indexMagic.size()) / sizeof(IndexEntry);
+		for (uint64_t entryPos = 0; entryPos < numEntries; ++entryPos) {
+			IndexEntry entry;
+			std::memcpy(&entry,
+					index.data_ + indexMagic.size() + entryPos * sizeof(IndexEntry),
+					sizeof(IndexEntry));
+			Key key;
+			key.hash1_ = entry.hash1_;
+			key.hash2_ = entry.hash2_;
+			liveRecords[entry.segment_][entry.record_] = key;
+		}
+	}
+	uint64_t loaded = 0;
+	for (const auto & segment : liveRecords) {
+		readSegment(segment.first,
+				[this, &alignerObj, &seqs, &segment, &loaded](uint32_t recordPos, Record & rec) {
+					auto keySearch = segment.second.find(recordPos);
+					if (segment.second.end() == keySearch) {
+						return;
+					}
+					if (!seqs.empty() && 0 == seqs.count(rec.seqA_) && 0 == seqs.count(rec.seqB_)) {
+						return;
+					}
+					auto & seqAInfos = alignerObj.alnHolder_.globalHolder_[rec.holderId_].infos_[rec.seqA_];
+					if (seqAInfos.end() == seqAInfos.find(rec.seqB_)) {
+						seqAInfos.emplace(rec.seqB_, rec.info_);
+					}
+					loaded_.emplace(keySearch->second);
+					++loaded;
+				});
+	}
+	return loaded;
+}
+
+uint64_t AlnCacheArchive::save(const aligner & alignerObj) {
+	ArchiveFileLock lock(lockFnp(), true);
+	uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+	std::vector<IndexEntry> entries;
+	std::unordered_set<Key, KeyHasher> archived;
+	//a process that died while writing the magic leaves less than the magic, start the index over
+	if (bfs::exists(indexFnp()) && bfs::file_size(indexFnp()) < indexMagic.size()) {
+		bfs::resize_file(indexFnp(), 0);
+	}
+	bool indexExists = bfs::exists(indexFnp()) && bfs::file_size(indexFnp()) > 0;
+	uint64_t validIndexSize = 0;
+	if (indexExists) {
+		//other processes may have added alignments since this one loaded, so re-read the index now that it's locked
+		ArchiveMappedFile index(indexFnp(), true);
+		if (0 != std::memcmp(index.data_, indexMagic.c_str(), indexMagic.size())) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error " << indexFnp() << " isn't an alignment cache index" << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		uint64_t numEntries = (index.size_ - indexMagic.size()) / sizeof(IndexEntry);
+		validIndexSize = indexMagic.size() + numEntries * sizeof(IndexEntry);
+		for (uint64_t entryPos = 0; entryPos < numEntries; ++entryPos) {
+			char * entryData = index.data_ + indexMagic.size() + entryPos * sizeof(IndexEntry);
+			IndexEntry entry;
+			std::memcpy(&entry, entryData, sizeof(IndexEntry));
+			Key key;
+			key.hash1_ = entry.hash1_;
+			key.hash2_ = entry.hash2_;
+			if (loaded_.count(key) > 0) {
+				entry.lastUsed_ = now;
+				std::memcpy(entryData, &entry, sizeof(IndexEntry));
+			}
+			archived.emplace(key);
+			entries.emplace_back(entry);
+		}
+	}
+	//a process that died while appending leaves a partial last entry which load() skips,
+	//drop it so new entries are appended on an entry boundary rather than misaligned after it
+	if (indexExists && bfs::file_size(indexFnp()) != validIndexSize) {
+		bfs::resize_file(indexFnp(), validIndexSize);
+	}
+	auto segments = getSegments();
+	uint32_t nextSegment = segments.empty() ? 0 : segments.back() + 1;
+	std::vector<Record> newRecords;
+	for (const auto & holder : alignerObj.alnHolder_.globalHolder_) {
+		for (const auto & seqAInfos : holder.second.infos_) {
+			for (const auto & seqBInfo : seqAInfos.second) {
+				auto key = genKey(holder.first, seqAInfos.first, seqBInfo.first);
+				if (!archived.emplace(key).second) {
+					continue;
+				}
+				Record rec;
+				rec.holderId_ = holder.first;
+				rec.seqA_ = seqAInfos.first;
+				rec.seqB_ = seqBInfo.first;
+				rec.info_ = seqBInfo.second;
+				newRecords.emplace_back(rec);
+				IndexEntry entry;
+				entry.hash1_ = key.hash1_;
+				entry.hash2_ = key.hash2_;
+				entry.segment_ = nextSegment;
+				entry.record_ = newRecords.size() - 1;
+				entry.lastUsed_ = now;
+				entries.emplace_back(entry);
+			}
+		}
+	}
+	if (!newRecords.empty()) {
+		writeSegment(nextSegment, newRecords);
+		std::ofstream indexOut(indexFnp().string(), std::ios::binary | std::ios::app);
+		if (!indexExists) {
+			indexOut.write(indexMagic.c_str(), indexMagic.size());
+		}
+		for (const auto & entry : entries) {
+			if (entry.segment_ == nextSegment) {
+				writeArchiveVal(indexOut, entry);
+			}
+		}
+		if (!indexOut) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error in appending to " << indexFnp() << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+	}
+	if (segmentsSize() > maxBytes_) {
+		compact(entries);
+	}
+	return newRecords.size();
+}
+
+void AlnCacheArchive::compact(const std::vector<IndexEntry> & entries) {
+	std::map<uint32_t, std::unordered_map<uint32_t, uint64_t>> lastUsed;
+	for (const auto & entry : entries) {
+		lastUsed[entry.segment_][entry.record_] = entry.lastUsed_;
+	}
+	std::vector<Record> records;
+	for (const auto & segment : lastUsed) {
+		readSegment(segment.first,
+				[&segment, &records](uint32_t recordPos, Record & rec) {
+					auto search = segment.second.find(recordPos);
+					if (segment.second.end() != search) {
+						rec.lastUsed_ = search->second;
+						records.emplace_back(std::move(rec));
+					}
+				});
+	}
+	std::stable_sort(records.begin(), records.end(),
+			[](const Record & rec1, const Record & rec2) {
+				return rec1.lastUsed_ > rec2.lastUsed_;
+			});
+	//compact down below the cap so the next few runs don't all have to compact again
+	uint64_t targetBytes = maxBytes_ / 4 * 3;
+	uint64_t keptBytes = 0;
+	uint32_t keep = 0;
+	for (const auto & rec : records) {
+		//upper bound of the written size, sequences shared between records are only written once
+		keptBytes += 29 + rec.holderId_.size() + rec.seqA_.size() + rec.seqB_.size()
+				+ 9 * rec.info_.gapInfos_.size();
+		if (keptBytes > targetBytes) {
+			break;
+		}
+		++keep;
+	}
+	records.resize(keep);
+	auto oldSegments = getSegments();
+	uint32_t nextSegment = oldSegments.empty() ? 0 : oldSegments.back() + 1;
+	writeSegment(nextSegment, records);
+	auto tempIndexFnp = bfs::path(indexFnp().string() + ".tmp");
+	{
+		std::ofstream indexOut(tempIndexFnp.string(), std::ios::binary | std::ios::trunc);
+		indexOut.write(indexMagic.c_str(), indexMagic.size());
+		for (const auto recordPos : iter::range<uint32_t>(records.size())) {
+			auto key = genKey(records[recordPos].holderId_, records[recordPos].seqA_,
+					records[recordPos].seqB_);
+			IndexEntry entry;
+			entry.hash1_ = key.hash1_;
+			entry.hash2_ = key.hash2_;
+			entry.segment_ = nextSegment;
+			entry.record_ = recordPos;
+			entry.lastUsed_ = records[recordPos].lastUsed_;
+			writeArchiveVal(indexOut, entry);
+		}
+		if (!indexOut) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error in writing " << tempIndexFnp << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+	}
+	bfs::rename(tempIndexFnp, indexFnp());
+	for (const auto & segment : oldSegments) {
+		bfs::remove(segmentFnp(segment));
+	}
+}
+
+}  // namespace bibseq
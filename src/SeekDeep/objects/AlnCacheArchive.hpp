@@ -0,0 +1,138 @@
+#pragma once
+/*
+ * AlnCacheArchive.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+
+
+namespace bibseq {
+
+/**@brief A binary on disk cache of global alignments that can be shared by several processes at once, e.g. all the replicates of a target
+ *
+ * The directory holds an index of fixed size entries (hashed sequence pair key, segment, record, last used time) that is memory mapped
+ * and append only segment files that hold the alignments, new alignments are written as a new segment and appended to the index under an exclusive file lock,
+ * readers take a shared lock, when the segments grow past the size cap the least recently used alignments are dropped and the rest compacted into one segment
+ *
+ */
+class AlnCacheArchive {
+public:
+
+	struct Key {
+		uint64_t hash1_{0};
+		uint64_t hash2_{0};
+		bool operator==(const Key & other) const;
+	};
+
+	struct KeyHasher {
+		size_t operator()(const Key & key) const;
+	};
+
+	/**@brief Entry in the index file, written as is so the layout needs to stay fixed
+	 *
+	 */
+	struct IndexEntry {
+		uint64_t hash1_;
+		uint64_t hash2_;
+		uint32_t segment_;
+		uint32_t record_; /**< position of the alignment within the segment */
+		uint64_t lastUsed_; /**< seconds since epoch the alignment was last loaded or added */
+	};
+
+	/**@brief Open or create an archive
+	 *
+	 * @param dirName the directory of the archive, created if it doesn't exist
+	 * @param maxBytes when the segments get larger than this the archive is compacted down to three quarters of this
+	 */
+	AlnCacheArchive(const bfs::path & dirName, uint64_t maxBytes);
+
+	const bfs::path dirName_;
+	uint64_t maxBytes_;
+
+	/**@brief Load the archived global alignments into the aligner's alignment cache
+	 *
+	 * @param alignerObj the aligner to load into
+	 * @param seqs only load alignments where at least one of the two sequences is in seqs, if empty all alignments are loaded
+	 * @return the number of alignments loaded
+	 */
+	uint64_t load(aligner & alignerObj, const std::unordered_set<std::string> & seqs);
+
+	/**@brief Add the aligner's cached global alignments that aren't archived yet as a new segment,
+	 * refresh the last used time of the alignments loaded by load() and compact the archive if it's over the size cap
+	 *
+	 * @param alignerObj the aligner to save from
+	 * @return the number of alignments added
+	 */
+	uint64_t save(const aligner & alignerObj);
+
+	/**@brief Total size of the segment files
+	 *
+	 */
+	uint64_t segmentsSize() const;
+
+	/**@brief Stable hash of an alignment so the key is the same across processes and builds
+	 *
+	 * @param holderId the identifier of the scoring the alignment was done with
+	 * @param seqA the first sequence
+	 * @param seqB the second sequence
+	 * @return the key
+	 */
+	static Key genKey(const std::string & holderId, const std::string & seqA,
+			const std::string & seqB);
+
+private:
+	struct Record {
+		std::string holderId_;
+		std::string seqA_;
+		std::string seqB_;
+		alnInfoGlobal info_;
+		uint64_t lastUsed_{0};
+	};
+
+	std::unordered_set<Key, KeyHasher> loaded_;
+
+	bfs::path indexFnp() const;
+	bfs::path lockFnp() const;
+	bfs::path segmentFnp(uint32_t segment) const;
+	std::vector<uint32_t> getSegments() const;
+
+	/**@brief Read a segment, calling func for each record in it
+	 *
+	 */
+	void readSegment(uint32_t segment,
+			const std::function<void(uint32_t, Record &)> & func) const;
+	void writeSegment(uint32_t segment, const std::vector<Record> & records) const;
+
+	/**@brief Drop the least recently used alignments until under three quarters of the size cap and rewrite what's left as one segment, must hold the exclusive lock
+	 *
+	 */
+	void compact(const std::vector<IndexEntry> & entries);
+};
+
+}  // namespace bibseq
+
+
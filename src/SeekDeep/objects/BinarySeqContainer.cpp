@@ -0,0 +1,358 @@
+/*
+ * BinarySeqContainer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "BinarySeqContainer.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace bibseq {
+
+namespace {
+
+const std::string containerMagic = "SDSEQBN1";
+//the 4 bit code of a base is its position in here
+const std::string packedBases = "-ACGTNRYSWKMBDHV";
+
+std::array<int16_t, 256> genBaseCodes() {
+	std::array<int16_t, 256> ret;
+	ret.fill(-1);
+	for (uint32_t code = 0; code < packedBases.size(); ++code) {
+		ret[static_cast<unsigned char>(packedBases[code])] = code;
+	}
+	return ret;
+}
+
+const std::array<int16_t, 256> baseCodes = genBaseCodes();
+
+template<typename T>
+void writeContainerVal(std::ostream & out, const T & val) {
+	out.write(reinterpret_cast<const char *>(&val), sizeof(T));
+}
+
+}  // namespace
+
+static_assert(sizeof(BinarySeqContainer::Header) == 48, "BinarySeqContainer::Header layout changed, the file format depends on it");
+static_assert(sizeof(BinarySeqContainer::Entry) == 48, "BinarySeqContainer::Entry layout changed, the file format depends on it");
+
+BinarySeqContainer::BinarySeqContainer(const bfs::path & fnp) :
+		fnp_(fnp) {
+	fd_ = ::open(fnp_.string().c_str(), O_RDONLY);
+	struct stat info;
+	if (fd_ < 0 || 0 != ::fstat(fd_, &info)) {
+		if (fd_ >= 0) {
+			::close(fd_);
+		}
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error in opening " << fnp_ << ", "
+				<< std::strerror(errno) << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	size_ = info.st_size;
+	if (size_ < containerMagic.size() + sizeof(Header)) {
+		::close(fd_);
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error " << fnp_ << " is too small to be a sequence container" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	data_ = static_cast<char *>(::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0));
+	if (MAP_FAILED == data_) {
+		data_ = nullptr;
+		::close(fd_);
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error in mapping " << fnp_ << ", "
+				<< std::strerror(errno) << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	//from here on the destructor won't run if there's a throw, so unmap before throwing
+	const std::string funcName = __PRETTY_FUNCTION__;
+	auto fail = [this,&funcName](const std::string & mess) {
+		::munmap(data_, size_);
+		::close(fd_);
+		std::stringstream ss;
+		ss << funcName << ", error " << fnp_ << " " << mess << "\n";
+		throw std::runtime_error { ss.str() };
+	};
+	if (0 != std::memcmp(data_, containerMagic.c_str(), containerMagic.size())) {
+		fail("isn't a sequence container");
+	}
+	std::memcpy(&header_, data_ + containerMagic.size(), sizeof(Header));
+	uint64_t entriesStart = containerMagic.size() + sizeof(Header);
+	if (header_.numSeqs_ > (size_ - entriesStart) / sizeof(Entry)
+			|| header_.namesStart_ < entriesStart + header_.numSeqs_ * sizeof(Entry)
+			|| header_.seqsStart_ < header_.namesStart_
+			|| header_.qualsStart_ < header_.seqsStart_
+			|| header_.qualsStart_ > size_) {
+		fail("is truncated");
+	}
+	//entries start 8 byte aligned in a page aligned mapping so they can be used in place
+	entries_ = reinterpret_cast<const Entry *>(data_ + entriesStart);
+	//check the entries once here so the getters don't have to
+	bool packed = header_.flags_ & packedFlag;
+	for (uint64_t pos = 0; pos < header_.numSeqs_; ++pos) {
+		const auto & entry = entries_[pos];
+		uint64_t seqBytes = packed ? (entry.seqLen_ + 1) / 2 : entry.seqLen_;
+		if (entry.nameOffset_ + entry.nameLen_ > header_.seqsStart_ - header_.namesStart_
+				|| entry.seqOffset_ + seqBytes > header_.qualsStart_ - header_.seqsStart_
+				|| (hasQual() && entry.qualOffset_ + entry.seqLen_ > size_ - header_.qualsStart_)) {
+			fail("is truncated");
+		}
+	}
+}
+
+BinarySeqContainer::~BinarySeqContainer() {
+	::munmap(data_, size_);
+	::close(fd_);
+}
+
+uint64_t BinarySeqContainer::size() const {
+	return header_.numSeqs_;
+}
+
+uint32_t BinarySeqContainer::maxLen() const {
+	return header_.maxLen_;
+}
+
+double BinarySeqContainer::totalCnt() const {
+	return header_.totalCnt_;
+}
+
+bool BinarySeqContainer::hasQual() const {
+	return header_.flags_ & hasQualFlag;
+}
+
+void BinarySeqContainer::checkPos(uint64_t pos) const {
+	if (pos >= header_.numSeqs_) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error position " << pos
+				<< " is out of bounds, " << fnp_ << " has " << header_.numSeqs_ << " sequences" << "\n";
+		throw std::out_of_range { ss.str() };
+	}
+}
+
+const BinarySeqContainer::Entry & BinarySeqContainer::getEntry(uint64_t pos) const {
+	checkPos(pos);
+	return entries_[pos];
+}
+
+std::string BinarySeqContainer::getName(uint64_t pos) const {
+	const auto & entry = getEntry(pos);
+	return std::string(data_ + header_.namesStart_ + entry.nameOffset_, entry.nameLen_);
+}
+
+std::string BinarySeqContainer::getSeq(uint64_t pos) const {
+	const auto & entry = getEntry(pos);
+	const char * bases = data_ + header_.seqsStart_ + entry.seqOffset_;
+	if (!(header_.flags_ & packedFlag)) {
+		return std::string(bases, entry.seqLen_);
+	}
+	std::string ret(entry.seqLen_, ' ');
+	for (uint32_t basePos = 0; basePos < entry.seqLen_; ++basePos) {
+		auto packedByte = static_cast<unsigned char>(bases[basePos / 2]);
+		ret[basePos] = packedBases[0 == basePos % 2 ? packedByte >> 4 : packedByte & 0xf];
+	}
+	return ret;
+}
+
+std::vector<uint32_t> BinarySeqContainer::getQual(uint64_t pos) const {
+	const auto & entry = getEntry(pos);
+	if (!hasQual()) {
+		return std::vector<uint32_t>(entry.seqLen_, 40);
+	}
+	const auto * quals = reinterpret_cast<const uint8_t *>(data_
+			+ header_.qualsStart_ + entry.qualOffset_);
+	return std::vector<uint32_t>(quals, quals + entry.seqLen_);
+}
+
+seqInfo BinarySeqContainer::getSeqInfo(uint64_t pos) const {
+	seqInfo ret(getName(pos), getSeq(pos), getQual(pos), entries_[pos].cnt_);
+	ret.frac_ = entries_[pos].frac_;
+	return ret;
+}
+
+std::vector<uint64_t> BinarySeqContainer::getPositions(
+		const std::function<bool(const Entry &)> & pred) const {
+	std::vector<uint64_t> ret;
+	for (uint64_t pos = 0; pos < header_.numSeqs_; ++pos) {
+		if (pred(entries_[pos])) {
+			ret.emplace_back(pos);
+		}
+	}
+	return ret;
+}
+
+std::vector<seqInfo> BinarySeqContainer::getSeqs(
+		const std::vector<uint64_t> & positions) const {
+	std::vector<seqInfo> ret;
+	ret.reserve(positions.size());
+	for (const auto & pos : positions) {
+		ret.emplace_back(getSeqInfo(pos));
+	}
+	return ret;
+}
+
+std::vector<seqInfo> BinarySeqContainer::getSeqs() const {
+	std::vector<seqInfo> ret;
+	ret.reserve(header_.numSeqs_);
+	for (uint64_t pos = 0; pos < header_.numSeqs_; ++pos) {
+		ret.emplace_back(getSeqInfo(pos));
+	}
+	return ret;
+}
+
+void BinarySeqContainer::write(const std::vector<seqInfo> & seqs,
+		const bfs::path & fnp, bool includeQual, bool overWrite) {
+	std::vector<const seqInfo *> seqPtrs;
+	seqPtrs.reserve(seqs.size());
+	for (const auto & seq : seqs) {
+		seqPtrs.emplace_back(&seq);
+	}
+	writeSeqs(seqPtrs, fnp, includeQual, overWrite);
+}
+
+void BinarySeqContainer::writeSeqs(const std::vector<const seqInfo *> & seqs,
+		const bfs::path & fnp, bool includeQual, bool overWrite) {
+	if (bfs::exists(fnp) && !overWrite) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error " << fnp << " already exists, use overWrite to over write it" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	Header header;
+	header.numSeqs_ = seqs.size();
+	header.totalCnt_ = 0;
+	header.maxLen_ = 0;
+	header.flags_ = packedFlag | (includeQual ? hasQualFlag : 0);
+	std::vector<Entry> entries(seqs.size());
+	uint64_t namesSize = 0;
+	uint64_t quals = 0;
+	for (uint64_t pos = 0; pos < seqs.size(); ++pos) {
+		const auto & seq = *seqs[pos];
+		if (seq.seq_.size() > std::numeric_limits<uint32_t>::max()
+				|| seq.name_.size() > std::numeric_limits<uint32_t>::max()) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error " << seq.name_ << " is too long to be stored" << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		if (includeQual && seq.qual_.size() != seq.seq_.size()) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error " << seq.name_ << " has "
+					<< seq.qual_.size() << " qualities for " << seq.seq_.size() << " bases" << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		for (const auto & base : seq.seq_) {
+			if (baseCodes[static_cast<unsigned char>(base)] < 0) {
+				header.flags_ &= ~packedFlag;
+				break;
+			}
+		}
+		auto & entry = entries[pos];
+		entry.nameOffset_ = namesSize;
+		entry.nameLen_ = seq.name_.size();
+		entry.seqLen_ = seq.seq_.size();
+		entry.qualOffset_ = quals;
+		entry.cnt_ = seq.cnt_;
+		entry.frac_ = seq.frac_;
+		namesSize += seq.name_.size();
+		quals += includeQual ? seq.seq_.size() : 0;
+		header.totalCnt_ += seq.cnt_;
+		header.maxLen_ = std::max<uint32_t>(header.maxLen_, seq.seq_.size());
+	}
+	//only pack when every base in the file can be packed so a reader doesn't have to check each sequence
+	bool packed = header.flags_ & packedFlag;
+	uint64_t seqsSize = 0;
+	for (auto & entry : entries) {
+		entry.seqOffset_ = seqsSize;
+		seqsSize += packed ? (entry.seqLen_ + 1) / 2 : entry.seqLen_;
+	}
+	header.namesStart_ = containerMagic.size() + sizeof(Header) + entries.size() * sizeof(Entry);
+	header.seqsStart_ = header.namesStart_ + namesSize;
+	header.qualsStart_ = header.seqsStart_ + seqsSize;
+
+	auto tempFnp = bfs::path(fnp.string() + ".tmp");
+	{
+		std::ofstream out(tempFnp.string(), std::ios::binary | std::ios::trunc);
+		if (!out) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error in opening " << tempFnp << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		out.write(containerMagic.c_str(), containerMagic.size());
+		writeContainerVal(out, header);
+		for (const auto & entry : entries) {
+			writeContainerVal(out, entry);
+		}
+		for (const auto & seq : seqs) {
+			out.write(seq->name_.c_str(), seq->name_.size());
+		}
+		std::string packedSeq;
+		for (const auto & seq : seqs) {
+			if (!packed) {
+				out.write(seq->seq_.c_str(), seq->seq_.size());
+				continue;
+			}
+			packedSeq.assign((seq->seq_.size() + 1) / 2, '\0');
+			for (uint32_t basePos = 0; basePos < seq->seq_.size(); ++basePos) {
+				auto code = baseCodes[static_cast<unsigned char>(seq->seq_[basePos])];
+				packedSeq[basePos / 2] |= static_cast<char>(0 == basePos % 2 ? code << 4 : code);
+			}
+			out.write(packedSeq.c_str(), packedSeq.size());
+		}
+		if (includeQual) {
+			std::vector<uint8_t> qualBytes;
+			for (const auto & seq : seqs) {
+				qualBytes.clear();
+				for (const auto & q : seq->qual_) {
+					qualBytes.emplace_back(std::min<uint32_t>(q, std::numeric_limits<uint8_t>::max()));
+				}
+				out.write(reinterpret_cast<const char *>(qualBytes.data()), qualBytes.size());
+			}
+		}
+		if (!out) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error in writing " << tempFnp << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+	}
+	bfs::rename(tempFnp, fnp);
+}
+
+bfs::path BinarySeqContainer::genFnp(const bfs::path & seqFnp) {
+	auto ret = seqFnp;
+	ret.replace_extension(".sdseq");
+	return ret;
+}
+
+bool BinarySeqContainer::hasCurrentContainer(const bfs::path & seqFnp) {
+	auto containerFnp = genFnp(seqFnp);
+	return bfs::exists(containerFnp) && bfs::exists(seqFnp)
+			&& bfs::last_write_time(containerFnp) >= bfs::last_write_time(seqFnp);
+}
+
+}  // namespace bibseq
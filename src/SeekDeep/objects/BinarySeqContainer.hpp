@@ -0,0 +1,156 @@
+#pragma once
+/*
+ * BinarySeqContainer.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+
+
+namespace bibseq {
+
+/**@brief A binary file of sequences that is memory mapped so loading it, random access to a sequence and filtering on counts costs no parsing
+ *
+ * The file is a fixed header, an index of fixed size entries (name, sequence and quality offsets, length, count and fraction) followed by
+ * a block of names, a block of bases packed 4 bits each (or 1 byte each when a sequence has a base outside of -ACGTN and the IUPAC codes) and a block of uint8 qualities
+ *
+ */
+class BinarySeqContainer {
+public:
+
+	/**@brief Header of the file, written as is so the layout needs to stay fixed
+	 *
+	 */
+	struct Header {
+		uint64_t numSeqs_;
+		uint64_t namesStart_; /**< file offset of the names block */
+		uint64_t seqsStart_; /**< file offset of the bases block */
+		uint64_t qualsStart_; /**< file offset of the qualities block */
+		double totalCnt_; /**< summed counts of all the sequences */
+		uint32_t maxLen_; /**< length of the longest sequence */
+		uint32_t flags_;
+	};
+
+	/**@brief Entry in the index, written as is so the layout needs to stay fixed, offsets are relative to the start of their block
+	 *
+	 */
+	struct Entry {
+		uint64_t nameOffset_;
+		uint64_t seqOffset_;
+		uint64_t qualOffset_;
+		uint32_t nameLen_;
+		uint32_t seqLen_;
+		double cnt_;
+		double frac_;
+	};
+
+	static const uint32_t hasQualFlag = 1; /**< qualities were stored */
+	static const uint32_t packedFlag = 2; /**< bases are packed 4 bits each */
+
+	/**@brief Memory map a container written by write()
+	 *
+	 * @param fnp the file to map
+	 */
+	explicit BinarySeqContainer(const bfs::path & fnp);
+	~BinarySeqContainer();
+	BinarySeqContainer(const BinarySeqContainer & other) = delete;
+	BinarySeqContainer & operator=(const BinarySeqContainer & other) = delete;
+
+	const bfs::path fnp_;
+
+	uint64_t size() const;
+	uint32_t maxLen() const;
+	double totalCnt() const;
+	bool hasQual() const;
+
+	const Entry & getEntry(uint64_t pos) const;
+	std::string getName(uint64_t pos) const;
+	std::string getSeq(uint64_t pos) const;
+	/**@brief Get the qualities of a sequence, all 40 when no qualities were stored
+	 *
+	 */
+	std::vector<uint32_t> getQual(uint64_t pos) const;
+	seqInfo getSeqInfo(uint64_t pos) const;
+
+	/**@brief Get the positions of the sequences whose entries pass pred, only the index is looked at so no sequences are decoded
+	 *
+	 * @param pred the filter, e.g. on cnt_ or seqLen_
+	 * @return the positions of the sequences that passed, in file order
+	 */
+	std::vector<uint64_t> getPositions(
+			const std::function<bool(const Entry &)> & pred) const;
+
+	/**@brief Decode the sequences at positions, all of the sequences if positions is empty
+	 *
+	 */
+	std::vector<seqInfo> getSeqs(const std::vector<uint64_t> & positions) const;
+	std::vector<seqInfo> getSeqs() const;
+
+	/**@brief Write seqs to a container file, written to a temporary file first and moved into place so a partial file is never mapped
+	 *
+	 * @param seqs the sequences to write
+	 * @param fnp the file to write to
+	 * @param includeQual whether to store the qualities
+	 * @param overWrite whether to overwrite fnp if it already exists
+	 */
+	static void write(const std::vector<seqInfo> & seqs, const bfs::path & fnp,
+			bool includeQual, bool overWrite);
+
+	template<typename T>
+	static void write(const std::vector<T> & reads, const bfs::path & fnp,
+			bool includeQual, bool overWrite) {
+		std::vector<const seqInfo *> seqs;
+		seqs.reserve(reads.size());
+		for (const auto & read : reads) {
+			seqs.emplace_back(&read.seqBase_);
+		}
+		writeSeqs(seqs, fnp, includeQual, overWrite);
+	}
+
+	/**@brief The container file that goes along with a sequence file, the sequence file with its extension replaced by .sdseq
+	 *
+	 */
+	static bfs::path genFnp(const bfs::path & seqFnp);
+
+	/**@brief Whether there's a container for seqFnp that was written no earlier than seqFnp, so can be used in its place
+	 *
+	 */
+	static bool hasCurrentContainer(const bfs::path & seqFnp);
+
+private:
+	char * data_ { nullptr };
+	size_t size_ { 0 };
+	int fd_ { -1 };
+	Header header_;
+	const Entry * entries_ { nullptr };
+
+	void checkPos(uint64_t pos) const;
+
+	static void writeSeqs(const std::vector<const seqInfo *> & seqs,
+			const bfs::path & fnp, bool includeQual, bool overWrite);
+};
+
+}  // namespace bibseq
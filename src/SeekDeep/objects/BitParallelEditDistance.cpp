@@ -0,0 +1,126 @@
+/*
+ * BitParallelEditDistance.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "BitParallelEditDistance.hpp"
+
+
+namespace bibseq {
+
+uint32_t BitParallelEditDistance::baseCode(char base) {
+	switch (base) {
+	case 'A':
+	case 'a':
+		return 0;
+	case 'C':
+	case 'c':
+		return 1;
+	case 'G':
+	case 'g':
+		return 2;
+	case 'T':
+	case 't':
+		return 3;
+	default:
+		return 4;
+	}
+}
+
+BitParallelEditDistance::BitParallelEditDistance(const std::string & pattern) :
+		patternLen_(pattern.size()), blocks_((pattern.size() + 63) / 64),
+		peq_(5 * blocks_, 0) {
+	for (const auto pos : iter::range<uint32_t>(patternLen_)) {
+		uint64_t bit = uint64_t(1) << (pos % 64);
+		uint32_t block = pos / 64;
+		auto code = baseCode(pattern[pos]);
+		if (4 == code) {
+			//matches anything
+			for (uint32_t otherCode = 0; otherCode < 5; ++otherCode) {
+				peq_[otherCode * blocks_ + block] |= bit;
+			}
+		} else {
+			peq_[code * blocks_ + block] |= bit;
+			peq_[4 * blocks_ + block] |= bit;
+		}
+	}
+}
+
+uint32_t BitParallelEditDistance::patternLen() const {
+	return patternLen_;
+}
+
+uint32_t BitParallelEditDistance::distance(const std::string & text) const {
+	if (0 == patternLen_) {
+		return text.size();
+	}
+	//vertical differences of each block, the first column is 0..patternLen_ so every row goes up by one
+	std::vector<uint64_t> pv(blocks_, ~uint64_t(0));
+	std::vector<uint64_t> mv(blocks_, 0);
+	//the score is only read from the pattern's last row, rows past it in the last block are padding that never feed back into the rows above
+	const uint64_t lastRowBit = uint64_t(1) << ((patternLen_ - 1) % 64);
+	const uint64_t highBit = uint64_t(1) << 63;
+	int64_t score = patternLen_;
+	for (const auto & base : text) {
+		auto code = baseCode(base);
+		const uint64_t * eqs = peq_.data() + code * blocks_;
+		//the top row goes up by one every column
+		int32_t hin = 1;
+		for (uint32_t block = 0; block < blocks_; ++block) {
+			//unknown text bases match every row
+			uint64_t eq = 4 == code ? ~uint64_t(0) : eqs[block];
+			uint64_t pvBlock = pv[block];
+			uint64_t mvBlock = mv[block];
+			uint64_t xv = eq | mvBlock;
+			if (hin < 0) {
+				eq |= 1;
+			}
+			uint64_t xh = (((eq & pvBlock) + pvBlock) ^ pvBlock) | eq;
+			uint64_t ph = mvBlock | ~(xh | pvBlock);
+			uint64_t mh = pvBlock & xh;
+			uint64_t outBit = block + 1 == blocks_ ? lastRowBit : highBit;
+			int32_t hout = 0;
+			if (ph & outBit) {
+				hout = 1;
+			} else if (mh & outBit) {
+				hout = -1;
+			}
+			ph <<= 1;
+			mh <<= 1;
+			if (hin < 0) {
+				mh |= 1;
+			} else if (hin > 0) {
+				ph |= 1;
+			}
+			pv[block] = mh | ~(xv | ph);
+			mv[block] = ph & xv;
+			hin = hout;
+		}
+		score += hin;
+	}
+	return static_cast<uint32_t>(score);
+}
+
+}  // namespace bibseq
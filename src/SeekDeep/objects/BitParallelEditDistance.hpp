@@ -0,0 +1,66 @@
+#pragma once
+/*
+ * BitParallelEditDistance.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+
+
+namespace bibseq {
+
+/**@brief Global (end to end) edit distance between two sequences computed 64 rows at a time with Myers' bit-vector algorithm
+ *
+ * Bases other than A, C, G and T (e.g. N) match any base so the distance is never more than the mismatches plus indel bases of any alignment of the two,
+ * which makes it a cheap lower bound to check before running the full aligner
+ *
+ */
+class BitParallelEditDistance {
+public:
+	/**@brief Set up the match bit vectors for the pattern sequence
+	 *
+	 * @param pattern the sequence to compare other sequences to
+	 */
+	explicit BitParallelEditDistance(const std::string & pattern);
+
+	/**@brief Get the global edit distance between the pattern and text
+	 *
+	 * @param text the sequence to compare to the pattern
+	 * @return the number of mismatches plus inserted and deleted bases needed to turn the pattern into text
+	 */
+	uint32_t distance(const std::string & text) const;
+
+	uint32_t patternLen() const;
+
+private:
+	uint32_t patternLen_;
+	uint32_t blocks_; /**< number of 64 row words the pattern takes */
+	std::vector<uint64_t> peq_; /**< for each base code (A, C, G, T, other) the blocks_ words with a bit set on the pattern rows that match it */
+
+	static uint32_t baseCode(char base);
+};
+
+}  // namespace bibseq
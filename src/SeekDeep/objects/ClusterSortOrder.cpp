@@ -0,0 +1,118 @@
+/*
+ * ClusterSortOrder.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "ClusterSortOrder.hpp"
+
+
+namespace bibseq {
+
+IncrementalCountOrder::IncrementalCountOrder(const std::vector<double> & counts,
+		std::function<bool(uint32_t, uint32_t)> tieBreak) :
+		order_(counts.size()), counts_(counts), states_(counts.size(), PosState::inOrder),
+		tieBreak_(tieBreak), size_(counts.size()) {
+	std::iota(order_.begin(), order_.end(), 0);
+	std::sort(order_.begin(), order_.end(),
+			[this](uint32_t pos1, uint32_t pos2) {
+				return goesBefore(pos1, pos2);
+			});
+}
+
+bool IncrementalCountOrder::goesBefore(uint32_t pos1, uint32_t pos2) const {
+	if (counts_[pos1] != counts_[pos2]) {
+		return counts_[pos1] > counts_[pos2];
+	}
+	if (tieBreak_) {
+		if (tieBreak_(pos1, pos2)) {
+			return true;
+		}
+		if (tieBreak_(pos2, pos1)) {
+			return false;
+		}
+	}
+	return pos1 < pos2;
+}
+
+void IncrementalCountOrder::checkPos(uint32_t pos, const std::string & funcName) const {
+	if (pos >= states_.size() || PosState::absent == states_[pos]) {
+		std::stringstream ss;
+		ss << funcName << ", error position " << pos
+				<< " isn't in the order" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+}
+
+void IncrementalCountOrder::setCount(uint32_t pos, double count) {
+	checkPos(pos, __PRETTY_FUNCTION__);
+	//always re-sorted even when the count is the same since what tieBreak looks at may have changed
+	counts_[pos] = count;
+	if (PosState::inOrder == states_[pos]) {
+		states_[pos] = PosState::changed;
+		pending_.emplace_back(pos);
+	}
+}
+
+void IncrementalCountOrder::remove(uint32_t pos) {
+	checkPos(pos, __PRETTY_FUNCTION__);
+	if (PosState::inOrder == states_[pos]) {
+		pending_.emplace_back(pos);
+	}
+	states_[pos] = PosState::absent;
+	--size_;
+}
+
+uint32_t IncrementalCountOrder::size() const {
+	return size_;
+}
+
+const std::vector<uint32_t> & IncrementalCountOrder::getOrder() {
+	if (pending_.empty()) {
+		return order_;
+	}
+	//pull out everything removed or changed, what's left is still sorted
+	order_.erase(std::remove_if(order_.begin(), order_.end(),
+			[this](uint32_t pos) {
+				return PosState::inOrder != states_[pos];
+			}), order_.end());
+	std::vector<uint32_t> changed;
+	for (const auto pos : pending_) {
+		if (PosState::changed == states_[pos]) {
+			changed.emplace_back(pos);
+			states_[pos] = PosState::inOrder;
+		}
+	}
+	pending_.clear();
+	auto comp = [this](uint32_t pos1, uint32_t pos2) {
+		return goesBefore(pos1, pos2);
+	};
+	std::sort(changed.begin(), changed.end(), comp);
+	auto unchangedSize = order_.size();
+	order_.insert(order_.end(), changed.begin(), changed.end());
+	std::inplace_merge(order_.begin(), order_.begin() + unchangedSize, order_.end(), comp);
+	return order_;
+}
+
+}  // namespace bibseq
@@ -0,0 +1,194 @@
+#pragma once
+/*
+ * ClusterSortOrder.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+
+
+namespace bibseq {
+
+/**@brief Sort clusters by sorting their positions rather than the clusters themselves
+ *
+ * Comparisons and re-sorts only move 4 byte positions, the clusters are then moved into the new order once
+ *
+ */
+class ClusterSortOrder {
+public:
+
+	/**@brief Get the positions of reads in the order given by comp, ties keep their input order
+	 *
+	 * @param reads the reads to order
+	 * @param comp returns true if the first read should go before the second
+	 * @return the positions of reads in sorted order
+	 */
+	template<typename T, typename COMP>
+	static std::vector<uint32_t> genOrder(const std::vector<T> & reads, COMP comp) {
+		std::vector<uint32_t> order(reads.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(),
+				[&reads,&comp](uint32_t pos1, uint32_t pos2) {
+					return comp(reads[pos1], reads[pos2]);
+				});
+		return order;
+	}
+
+	/**@brief Whether read1 goes before read2 by total count (high to low), then fraction (high to low), then name
+	 *
+	 */
+	template<typename T>
+	static bool totalCountFirst(const T & read1, const T & read2) {
+		if (read1.seqBase_.cnt_ != read2.seqBase_.cnt_) {
+			return read1.seqBase_.cnt_ > read2.seqBase_.cnt_;
+		}
+		if (read1.seqBase_.frac_ != read2.seqBase_.frac_) {
+			return read1.seqBase_.frac_ > read2.seqBase_.frac_;
+		}
+		return read1.seqBase_.name_ < read2.seqBase_.name_;
+	}
+
+	/**@brief Get the positions of reads ordered by total count (high to low), then fraction (high to low), then name
+	 *
+	 * @param reads the reads to order
+	 * @return the positions of reads in sorted order
+	 */
+	template<typename T>
+	static std::vector<uint32_t> genTotalCountOrder(const std::vector<T> & reads) {
+		return genOrder(reads, totalCountFirst<T>);
+	}
+
+	/**@brief Move reads into the given order, each read is moved once (plus once per cycle in the permutation)
+	 *
+	 * @param reads the reads to reorder
+	 * @param order the positions of reads in their new order, has to be a permutation of 0 to reads.size() - 1
+	 */
+	template<typename T>
+	static void applyOrder(std::vector<T> & reads, const std::vector<uint32_t> & order) {
+		if (order.size() != reads.size()) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error order size, " << order.size()
+					<< ", doesn't match reads size, " << reads.size() << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		std::vector<bool> placed(order.size(), false);
+		for (uint32_t start = 0; start < order.size(); ++start) {
+			if (placed[start]) {
+				continue;
+			}
+			//follow the cycle starting at start, pulling each read into its new position
+			T startRead = std::move(reads[start]);
+			uint32_t pos = start;
+			while (order[pos] != start) {
+				reads[pos] = std::move(reads[order[pos]]);
+				placed[pos] = true;
+				pos = order[pos];
+			}
+			reads[pos] = std::move(startRead);
+			placed[pos] = true;
+		}
+	}
+
+	/**@brief Sort reads by total count (high to low), then fraction (high to low), then name
+	 *
+	 * @param reads the reads to sort
+	 */
+	template<typename T>
+	static void sortByTotalCount(std::vector<T> & reads) {
+		applyOrder(reads, genTotalCountOrder(reads));
+	}
+};
+
+/**@brief Keep positions ordered by count (high to low) while counts change
+ *
+ * Positions are kept in one flat vector, changes are only recorded until getOrder() is called which then drops the removed positions
+ * and merges the changed ones back in, so only the changed positions are re-sorted rather than everything
+ *
+ */
+class IncrementalCountOrder {
+public:
+	/**@brief Start with positions 0 to counts.size() - 1, ties are ordered by tieBreak and then by position
+	 *
+	 * @param counts the starting count of each position
+	 * @param tieBreak returns true if the first position should go before the second when their counts are equal, nullptr to only use position
+	 */
+	IncrementalCountOrder(const std::vector<double> & counts,
+			std::function<bool(uint32_t, uint32_t)> tieBreak = nullptr);
+
+	/**@brief Start with the positions of reads ordered like ClusterSortOrder::totalCountFirst, count then fraction (high to low) then name
+	 *
+	 * reads is read again whenever changed positions are re-sorted so it has to outlive this object,
+	 * a read's fraction and name should only change along with a call to setCount for its position
+	 *
+	 * @param reads the reads to order
+	 */
+	template<typename T>
+	explicit IncrementalCountOrder(const std::vector<T> & reads) :
+			IncrementalCountOrder(getCounts(reads), [&reads](uint32_t pos1, uint32_t pos2) {
+				if (reads[pos1].seqBase_.frac_ != reads[pos2].seqBase_.frac_) {
+					return reads[pos1].seqBase_.frac_ > reads[pos2].seqBase_.frac_;
+				}
+				return reads[pos1].seqBase_.name_ < reads[pos2].seqBase_.name_;
+			}) {
+	}
+
+	void setCount(uint32_t pos, double count);
+	void remove(uint32_t pos);
+
+	uint32_t size() const;
+
+	/**@brief Get the positions currently held, highest count first, applying any changes since the last call
+	 *
+	 * @return the positions, only valid until the next call
+	 */
+	const std::vector<uint32_t> & getOrder();
+
+private:
+	enum class PosState : uint8_t {
+		absent, inOrder, changed
+	};
+	std::vector<uint32_t> order_;
+	std::vector<double> counts_;
+	std::vector<PosState> states_;
+	std::vector<uint32_t> pending_; /**< positions removed or changed since the last getOrder() */
+	std::function<bool(uint32_t, uint32_t)> tieBreak_;
+	uint32_t size_{0};
+
+	bool goesBefore(uint32_t pos1, uint32_t pos2) const;
+	void checkPos(uint32_t pos, const std::string & funcName) const;
+
+	template<typename T>
+	static std::vector<double> getCounts(const std::vector<T> & reads) {
+		std::vector<double> counts;
+		counts.reserve(reads.size());
+		for (const auto & read : reads) {
+			counts.emplace_back(read.seqBase_.cnt_);
+		}
+		return counts;
+	}
+};
+
+}  // namespace bibseq
@@ -0,0 +1,639 @@
+/*
+ * CmdJobScheduler.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "CmdJobScheduler.hpp"
+
+
+namespace bibseq {
+
+CmdJobLedger::CmdJobLedger(const bfs::path & ledgerFnp) :
+		ledgerFnp_(ledgerFnp) {
+	out_.open(ledgerFnp_.string(), std::ios::app);
+	if (!out_) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error in opening " << ledgerFnp_
+				<< " for appending" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+}
+
+void CmdJobLedger::writeLine(const std::string & event, uint32_t index,
+		int32_t exitCode, double duration, const std::string & cmd) {
+	std::lock_guard<std::mutex> lock(mut_);
+	out_ << event
+			<< "\t" << index
+			<< "\t" << std::time(nullptr)
+			<< "\t" << exitCode
+			<< "\t" << duration
+			<< "\t" << escapeCmd(cmd) << std::endl;
+}
+
+std::string CmdJobLedger::escapeCmd(const std::string & cmd) {
+	std::string ret;
+	ret.reserve(cmd.size());
+	for (const auto & c : cmd) {
+		switch (c) {
+		case '\\':
+			ret.append("\\\\");
+			break;
+		case '\n':
+			ret.append("\\n");
+			break;
+		case '\r':
+			ret.append("\\r");
+			break;
+		default:
+			ret.push_back(c);
+			break;
+		}
+	}
+	return ret;
+}
+
+std::string CmdJobLedger::unescapeCmd(const std::string & escaped) {
+	std::string ret;
+	ret.reserve(escaped.size());
+	for (size_t pos = 0; pos < escaped.size(); ++pos) {
+		if ('\\' != escaped[pos] || pos + 1 == escaped.size()) {
+			ret.push_back(escaped[pos]);
+			continue;
+		}
+		++pos;
+		switch (escaped[pos]) {
+		case 'n':
+			ret.push_back('\n');
+			break;
+		case 'r':
+			ret.push_back('\r');
+			break;
+		default:
+			ret.push_back(escaped[pos]);
+			break;
+		}
+	}
+	return ret;
+}
+
+void CmdJobLedger::logReset() {
+	writeLine("reset", 0, 0, 0, "");
+}
+
+void CmdJobLedger::logStart(uint32_t index, const std::string & cmd) {
+	writeLine("start", index, 0, 0, cmd);
+}
+
+void CmdJobLedger::logFinish(uint32_t index, const std::string & cmd,
+		const bib::sys::RunOutput & out) {
+	writeLine("finish", index, out.returnCode_, out.time_, cmd);
+}
+
+std::unordered_set<std::string> CmdJobLedger::getSuccessfullyFinished() const {
+	std::unordered_set<std::string> ret;
+	if (!bfs::exists(ledgerFnp_)) {
+		return ret;
+	}
+	std::ifstream inFile(ledgerFnp_.string());
+	std::string line;
+	while (bib::files::crossPlatGetline(inFile, line)) {
+		//command is last and can contain tabs so only split the first five columns off
+		VecStr toks;
+		size_t lastPos = 0;
+		while (toks.size() < 5) {
+			auto tabPos = line.find('\t', lastPos);
+			if (std::string::npos == tabPos) {
+				break;
+			}
+			toks.emplace_back(line.substr(lastPos, tabPos - lastPos));
+			lastPos = tabPos + 1;
+		}
+		//a partially written last line from an interrupted run is skipped
+		if (5 != toks.size()) {
+			continue;
+		}
+		if ("reset" == toks[0]) {
+			ret.clear();
+		} else if ("finish" == toks[0] && "0" == toks[3]) {
+			ret.emplace(unescapeCmd(line.substr(lastPos)));
+		}
+	}
+	return ret;
+}
+
+CmdJobScheduler::Job::Job(const std::string & cmd, uint32_t index) :
+		cmd_(cmd), index_(index) {
+}
+
+CmdJobScheduler::CmdJobScheduler(const VecStr & cmds, uint32_t numThreads) :
+		numThreads_(std::max<uint32_t>(numThreads, 1)) {
+	for (const auto pos : iter::range(cmds.size())) {
+		jobs_.emplace_back(cmds[pos], pos);
+	}
+	numIndexes_ = jobs_.size();
+}
+
+CmdJobScheduler::CmdJobScheduler(const Json::Value & dagJson,
+		uint32_t numThreads) :
+		numThreads_(std::max<uint32_t>(numThreads, 1)) {
+	if (!dagJson.isMember("jobs") || !dagJson["jobs"].isArray()) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error dag json needs a jobs array" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	std::unordered_map<std::string, uint32_t> nameToIndex;
+	for (const auto & jobJson : dagJson["jobs"]) {
+		if (!jobJson.isMember("name") || !jobJson.isMember("cmd")) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error each job needs a name and a cmd"
+					<< "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		auto name = jobJson["name"].asString();
+		if (nameToIndex.end() != nameToIndex.find(name)) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error job name " << name
+					<< " was found more than once" << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		nameToIndex[name] = jobs_.size();
+		jobs_.emplace_back(jobJson["cmd"].asString(), jobs_.size());
+		jobs_.back().name_ = name;
+	}
+	for (const auto & jobJson : dagJson["jobs"]) {
+		auto & job = jobs_[nameToIndex[jobJson["name"].asString()]];
+		for (const auto & dep : jobJson["deps"]) {
+			auto search = nameToIndex.find(dep.asString());
+			if (nameToIndex.end() == search) {
+				std::stringstream ss;
+				ss << __PRETTY_FUNCTION__ << ", error job " << job.name_
+						<< " depends on " << dep.asString() << " which isn't in the dag" << "\n";
+				throw std::runtime_error { ss.str() };
+			}
+			job.deps_.emplace_back(search->second);
+		}
+	}
+	numIndexes_ = jobs_.size();
+	checkForCycles();
+}
+
+Json::Value CmdJobScheduler::genDagJob(const std::string & name,
+		const std::string & cmd, const VecStr & deps) {
+	Json::Value ret;
+	ret["name"] = bib::json::toJson(name);
+	ret["cmd"] = bib::json::toJson(cmd);
+	ret["deps"] = Json::arrayValue;
+	for (const auto & dep : deps) {
+		ret["deps"].append(dep);
+	}
+	return ret;
+}
+
+void CmdJobScheduler::checkForCycles() const {
+	//kahn's algorithm, if not every job can be ordered there's a cycle
+	std::vector<uint32_t> unmetDeps(numIndexes_, 0);
+	std::unordered_map<uint32_t, std::vector<uint32_t>> dependents;
+	for (const auto & job : jobs_) {
+		unmetDeps[job.index_] = job.deps_.size();
+		for (const auto & dep : job.deps_) {
+			dependents[dep].emplace_back(job.index_);
+		}
+	}
+	std::vector<uint32_t> ready;
+	for (const auto & job : jobs_) {
+		if (0 == unmetDeps[job.index_]) {
+			ready.emplace_back(job.index_);
+		}
+	}
+	uint32_t ordered = 0;
+	while (!ready.empty()) {
+		auto index = ready.back();
+		ready.pop_back();
+		++ordered;
+		for (const auto & dependent : dependents[index]) {
+			if (0 == --unmetDeps[dependent]) {
+				ready.emplace_back(dependent);
+			}
+		}
+	}
+	if (ordered != jobs_.size()) {
+		VecStr inCycle;
+		for (const auto & job : jobs_) {
+			if (0 != unmetDeps[job.index_]) {
+				inCycle.emplace_back("" == job.name_ ? estd::to_string(job.index_) : job.name_);
+			}
+		}
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error dag contains a cycle, the following jobs can never start: "
+				<< bib::conToStr(inCycle, ",") << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+}
+
+std::vector<bfs::path> CmdJobScheduler::getInputFnpsFromCmd(
+		const std::string & cmd) {
+	std::vector<bfs::path> ret;
+	auto toks = tokenizeString(cmd, "whitespace");
+	bfs::path currentDir = "";
+	for (const auto pos : iter::range(toks.size())) {
+		auto tok = toks[pos];
+		tok.erase(std::remove(tok.begin(), tok.end(), '"'), tok.end());
+		tok.erase(std::remove(tok.begin(), tok.end(), '\''), tok.end());
+		if ("" == tok || bib::beginsWith(tok, "-")) {
+			continue;
+		}
+		//commands created by setupTarAmpAnalysis change directory first
+		if ("cd" == tok && pos + 1 < toks.size()) {
+			currentDir = toks[pos + 1];
+			currentDir = bib::replaceString(currentDir.string(), "\"", "");
+			continue;
+		}
+		bfs::path fnp = tok;
+		if (fnp.is_relative() && "" != currentDir) {
+			fnp = bib::files::make_path(currentDir, fnp);
+		}
+		if (bfs::exists(fnp) && bfs::is_regular_file(fnp)
+				&& !bib::in(fnp, ret)) {
+			ret.emplace_back(fnp);
+		}
+	}
+	return ret;
+}
+
+uint64_t CmdJobScheduler::getInputSizeFromCmd(const std::string & cmd) {
+	uint64_t ret = 0;
+	for (const auto & fnp : getInputFnpsFromCmd(cmd)) {
+		ret += bfs::file_size(fnp);
+	}
+	return ret;
+}
+
+void CmdJobScheduler::setCostsFromInputSizes() {
+	std::unordered_map<uint32_t, uint32_t> indexToPos;
+	std::unordered_map<uint32_t, uint32_t> dependentCounts;
+	for (const auto pos : iter::range(jobs_.size())) {
+		auto & job = jobs_[pos];
+		job.cost_ = getInputSizeFromCmd(job.cmd_);
+		job.costFromLog_ = false;
+		indexToPos[job.index_] = pos;
+		for (const auto & dep : job.deps_) {
+			++dependentCounts[dep];
+		}
+	}
+	//in a dag the inputs of later jobs are usually written by the jobs they depend on and don't exist yet,
+	//so a job is at least as costly as its share of what its dependencies read, each dependency's cost split evenly between the jobs waiting on it
+	std::unordered_set<uint32_t> estimated;
+	std::function<double(uint32_t)> getCost = [&](uint32_t index) -> double {
+		auto & job = jobs_[indexToPos[index]];
+		if (!job.deps_.empty() && estimated.emplace(index).second) {
+			double fromDeps = 0;
+			for (const auto & dep : job.deps_) {
+				if (indexToPos.end() != indexToPos.find(dep)) {
+					fromDeps += getCost(dep) / dependentCounts[dep];
+				}
+			}
+			job.cost_ = std::max(job.cost_, fromDeps);
+		}
+		return job.cost_;
+	};
+	for (const auto & job : jobs_) {
+		getCost(job.index_);
+	}
+}
+
+uint32_t CmdJobScheduler::setCostsFromPreviousLog(const bfs::path & logFnp) {
+	bib::files::checkExistenceThrow(logFnp, __PRETTY_FUNCTION__);
+	auto logJson = bib::json::parseFile(logFnp.string());
+	if (!logJson.isMember("cmdsLog")) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error " << logFnp
+				<< " doesn't contain cmdsLog, should be the log from runMultipleCommands"
+				<< "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	std::unordered_map<std::string, double> previousTimes;
+	for (const auto & cmdLog : logJson["cmdsLog"]) {
+		if (cmdLog.isMember("cmd_") && cmdLog.isMember("time_")) {
+			previousTimes[cmdLog["cmd_"].asString()] = cmdLog["time_"].asDouble();
+		}
+	}
+	uint32_t matched = 0;
+	double matchedTime = 0;
+	double matchedBytes = 0;
+	std::vector<uint64_t> sizes(jobs_.size(), 0);
+	for (const auto pos : iter::range(jobs_.size())) {
+		auto & job = jobs_[pos];
+		sizes[pos] = getInputSizeFromCmd(job.cmd_);
+		auto search = previousTimes.find(job.cmd_);
+		if (previousTimes.end() != search) {
+			job.cost_ = search->second;
+			job.costFromLog_ = true;
+			++matched;
+			matchedTime += search->second;
+			matchedBytes += sizes[pos];
+		}
+	}
+	//estimate the commands not found in the log, by seconds per byte if possible otherwise by the mean run time
+	if (matched > 0 && matched < jobs_.size()) {
+		double secondsPerByte = matchedBytes > 0 ? matchedTime / matchedBytes : 0;
+		double meanTime = matchedTime / matched;
+		for (const auto pos : iter::range(jobs_.size())) {
+			auto & job = jobs_[pos];
+			if (!job.costFromLog_) {
+				job.cost_ = (secondsPerByte > 0 && sizes[pos] > 0) ?
+								sizes[pos] * secondsPerByte : meanTime;
+			}
+		}
+	} else if (0 == matched) {
+		setCostsFromInputSizes();
+	}
+	return matched;
+}
+
+void CmdJobScheduler::setThreadsFromCmds(const std::string & threadFlag) {
+	for (auto & job : jobs_) {
+		auto toks = tokenizeString(job.cmd_, "whitespace");
+		for (const auto pos : iter::range(toks.size())) {
+			if (threadFlag == toks[pos] && pos + 1 < toks.size()
+					&& std::all_of(toks[pos + 1].begin(), toks[pos + 1].end(), ::isdigit)) {
+				job.threads_ = bib::lexical_cast<uint32_t>(toks[pos + 1]);
+			}
+		}
+		job.threads_ = std::min(std::max<uint32_t>(job.threads_, 1), numThreads_);
+	}
+}
+
+void CmdJobScheduler::sortByCost() {
+	//priority is the job's cost plus the most expensive chain of jobs waiting on it (bottom level), without dependencies it's just the cost
+	std::unordered_map<uint32_t, std::vector<uint32_t>> dependents;
+	std::unordered_map<uint32_t, uint32_t> indexToPos;
+	for (const auto pos : iter::range(jobs_.size())) {
+		indexToPos[jobs_[pos].index_] = pos;
+		for (const auto & dep : jobs_[pos].deps_) {
+			dependents[dep].emplace_back(jobs_[pos].index_);
+		}
+	}
+	std::unordered_map<uint32_t, double> priorities;
+	std::function<double(uint32_t)> getPriority = [&](uint32_t index) -> double {
+		auto search = priorities.find(index);
+		if (priorities.end() != search) {
+			return search->second;
+		}
+		double maxDependent = 0;
+		for (const auto & dependent : dependents[index]) {
+			maxDependent = std::max(maxDependent, getPriority(dependent));
+		}
+		double priority = jobs_[indexToPos[index]].cost_ + maxDependent;
+		priorities[index] = priority;
+		return priority;
+	};
+	for (const auto & job : jobs_) {
+		getPriority(job.index_);
+	}
+	std::stable_sort(jobs_.begin(), jobs_.end(),
+			[&priorities](const Job & job1, const Job & job2) {
+				return priorities[job1.index_] > priorities[job2.index_];
+			});
+}
+
+uint32_t CmdJobScheduler::getNextJob(std::vector<uint32_t> & states,
+		uint32_t & jobPos) const {
+	//rescan after marking any job as skipped so a failure is carried down to jobs that come earlier in the order
+	bool markedSkipped = true;
+	while (markedSkipped) {
+		markedSkipped = false;
+		bool anyPending = false;
+		for (const auto pos : iter::range(jobs_.size())) {
+			const auto & job = jobs_[pos];
+			if (0 != states[job.index_]) {
+				continue;
+			}
+			bool ready = true;
+			bool depFailed = false;
+			for (const auto & dep : job.deps_) {
+				if (3 == states[dep]) {
+					depFailed = true;
+					break;
+				}
+				if (2 != states[dep]) {
+					ready = false;
+				}
+			}
+			if (depFailed) {
+				states[job.index_] = 3;
+				markedSkipped = true;
+				continue;
+			}
+			if (ready && !markedSkipped) {
+				jobPos = pos;
+				return 1;
+			}
+			anyPending = true;
+		}
+		if (!markedSkipped) {
+			return anyPending ? 2 : 0;
+		}
+	}
+	return 0;
+}
+
+double CmdJobScheduler::predictMakespan() const {
+	//list scheduling, the first job in order whose dependencies are done starts once enough slots are free
+	//jobs not in the scheduler (e.g. removed as already finished) count as done
+	std::vector<uint32_t> states(numIndexes_, 2);
+	for (const auto & job : jobs_) {
+		states[job.index_] = 0;
+	}
+	std::multimap<double, uint32_t> running;
+	uint32_t freeSlots = numThreads_;
+	double currentTime = 0;
+	while (true) {
+		uint32_t jobPos = 0;
+		auto status = getNextJob(states, jobPos);
+		if (0 == status) {
+			break;
+		}
+		if (1 == status && freeSlots >= jobs_[jobPos].threads_) {
+			const auto & job = jobs_[jobPos];
+			freeSlots -= job.threads_;
+			states[job.index_] = 1;
+			running.emplace(currentTime + job.cost_, jobPos);
+			continue;
+		}
+		auto finished = running.begin();
+		currentTime = finished->first;
+		freeSlots += jobs_[finished->second].threads_;
+		states[jobs_[finished->second].index_] = 2;
+		running.erase(finished);
+	}
+	for (const auto & finished : running) {
+		currentTime = std::max(currentTime, finished.first);
+	}
+	return currentTime;
+}
+
+std::vector<bib::sys::RunOutput> CmdJobScheduler::run(bool verbose) {
+	return run(verbose, nullptr, false);
+}
+
+std::vector<bib::sys::RunOutput> CmdJobScheduler::run(bool verbose,
+		CmdJobLedger * ledger, bool progress) {
+	std::map<uint32_t, bib::sys::RunOutput> outputs;
+	std::mutex slotsMut;
+	std::condition_variable slotsCv;
+	uint32_t freeSlots = numThreads_;
+	//jobs not in the scheduler (e.g. removed as already finished) count as done
+	std::vector<uint32_t> states(numIndexes_, 2);
+	for (const auto & job : jobs_) {
+		states[job.index_] = 0;
+	}
+	uint32_t running = 0;
+	uint32_t failed = 0;
+	double totalCost = 0;
+	double doneCost = 0;
+	for (const auto & job : jobs_) {
+		totalCost += job.cost_;
+	}
+	bib::stopWatch watch;
+	auto printProgress = [this,&outputs,&running,&failed,&totalCost,&doneCost,&watch](){
+		double elapsed = watch.totalTime();
+		double eta = 0;
+		if (totalCost > 0 && doneCost > 0) {
+			eta = elapsed * (totalCost - doneCost) / doneCost;
+		} else if (!outputs.empty()) {
+			eta = elapsed * (jobs_.size() - outputs.size()) / outputs.size();
+		}
+		std::cout << "\r" << "done: " << outputs.size() << "/" << jobs_.size()
+				<< ", running: " << running
+				<< ", failed: " << failed
+				<< ", ETA: " << bib::sec2dur(eta) << "        ";
+		std::cout.flush();
+	};
+	//each worker takes the first job in order whose dependencies are done once enough slots are free, so a multi-threaded job holds back the jobs behind it
+	auto runJobs = [&](){
+		while(true){
+			uint32_t jobPos = 0;
+			{
+				std::unique_lock<std::mutex> lock(slotsMut);
+				uint32_t status = 0;
+				while (true) {
+					status = getNextJob(states, jobPos);
+					if (0 == status
+							|| (1 == status && freeSlots >= jobs_[jobPos].threads_)) {
+						break;
+					}
+					slotsCv.wait(lock);
+				}
+				if (0 == status) {
+					break;
+				}
+				states[jobs_[jobPos].index_] = 1;
+				++running;
+				freeSlots -= jobs_[jobPos].threads_;
+				if (verbose) {
+					std::cout << "Starting: " << jobs_[jobPos].cmd_ << std::endl;
+				}
+			}
+			if (nullptr != ledger) {
+				ledger->logStart(jobs_[jobPos].index_, jobs_[jobPos].cmd_);
+			}
+			auto out = bib::sys::run(VecStr{jobs_[jobPos].cmd_});
+			if (nullptr != ledger) {
+				ledger->logFinish(jobs_[jobPos].index_, jobs_[jobPos].cmd_, out);
+			}
+			{
+				std::lock_guard<std::mutex> lock(slotsMut);
+				outputs.emplace(jobs_[jobPos].index_, out);
+				states[jobs_[jobPos].index_] = out.success_ ? 2 : 3;
+				freeSlots += jobs_[jobPos].threads_;
+				--running;
+				doneCost += jobs_[jobPos].cost_;
+				if (!out.success_) {
+					++failed;
+				}
+				if (progress) {
+					printProgress();
+				}
+			}
+			slotsCv.notify_all();
+		}
+		slotsCv.notify_all();
+	};
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < numThreads_; ++t) {
+		threads.emplace_back(std::thread(runJobs));
+	}
+	for (auto & t : threads) {
+		t.join();
+	}
+	if (progress) {
+		std::cout << std::endl;
+	}
+	skipped_.clear();
+	for (const auto & job : jobs_) {
+		if (3 == states[job.index_] && outputs.end() == outputs.find(job.index_)) {
+			skipped_.emplace_back(job.index_);
+		}
+	}
+	std::sort(skipped_.begin(), skipped_.end());
+	std::vector<bib::sys::RunOutput> ret;
+	for (const auto & out : outputs) {
+		ret.emplace_back(out.second);
+	}
+	return ret;
+}
+
+uint32_t CmdJobScheduler::removeFinished(const CmdJobLedger & ledger) {
+	auto finished = ledger.getSuccessfullyFinished();
+	auto before = jobs_.size();
+	jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(),
+			[&finished](const Job & job) {
+				return finished.end() != finished.find(job.cmd_);
+			}), jobs_.end());
+	return before - jobs_.size();
+}
+
+Json::Value CmdJobScheduler::scheduleJson() const {
+	Json::Value ret;
+	auto & jobsJson = ret["jobs"];
+	for (const auto & job : jobs_) {
+		Json::Value jobJson;
+		jobJson["cmd"] = bib::json::toJson(job.cmd_);
+		jobJson["index"] = bib::json::toJson(job.index_);
+		jobJson["cost"] = bib::json::toJson(job.cost_);
+		jobJson["costFromLog"] = bib::json::toJson(job.costFromLog_);
+		jobJson["threads"] = bib::json::toJson(job.threads_);
+		if ("" != job.name_) {
+			jobJson["name"] = bib::json::toJson(job.name_);
+			jobJson["deps"] = bib::json::toJson(job.deps_);
+		}
+		jobsJson.append(jobJson);
+	}
+	ret["numThreads"] = bib::json::toJson(numThreads_);
+	ret["predictedMakespan"] = bib::json::toJson(predictMakespan());
+	return ret;
+}
+
+}  // namespace bibseq
@@ -0,0 +1,203 @@
+#pragma once
+/*
+ * CmdJobScheduler.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+
+
+namespace bibseq {
+
+/**@brief Append only record of when commands started and finished so an interrupted run can be resumed
+ *
+ * Tab delimited lines of event(reset/start/finish), command index, epoch time, exit code, duration in seconds, command,
+ * the command has its backslashes, newlines and carriage returns escaped so each event stays on one line
+ *
+ */
+class CmdJobLedger {
+public:
+	CmdJobLedger(const bfs::path & ledgerFnp);
+
+	const bfs::path ledgerFnp_;
+
+	/**@brief Read the ledger for the commands that already finished with an exit code of 0
+	 *
+	 * @return the finished commands
+	 */
+	std::unordered_set<std::string> getSuccessfullyFinished() const;
+
+	/**@brief Mark the start of a fresh run, commands finished before this are no longer considered finished
+	 *
+	 */
+	void logReset();
+	void logStart(uint32_t index, const std::string & cmd);
+	void logFinish(uint32_t index, const std::string & cmd,
+			const bib::sys::RunOutput & out);
+
+	/**@brief Escape backslashes, newlines and carriage returns so a command can be written on one line
+	 *
+	 */
+	static std::string escapeCmd(const std::string & cmd);
+	static std::string unescapeCmd(const std::string & escaped);
+
+private:
+	std::ofstream out_;
+	std::mutex mut_;
+
+	void writeLine(const std::string & event, uint32_t index, int32_t exitCode,
+			double duration, const std::string & cmd);
+};
+
+/**@brief Schedule shell commands over a fixed number of thread slots, longest first
+ *
+ * Each command gets a cost (input bytes or a runtime from a previous run) and a number of slots it occupies,
+ * commands are then started in decreasing cost order (LPT) as soon as enough slots are free,
+ * jobs can also depend on other jobs so that a whole analysis can be run as one dag without a barrier between each step
+ *
+ */
+class CmdJobScheduler {
+public:
+
+	struct Job {
+		Job(const std::string & cmd, uint32_t index);
+		std::string cmd_;
+		uint32_t index_; /**< position of the command in the input command list */
+		double cost_{0}; /**< estimated cost, bytes of input or seconds from a previous run */
+		bool costFromLog_{false}; /**< whether the cost came from a previous run's log */
+		uint32_t threads_{1}; /**< number of slots the command occupies while running */
+		std::string name_; /**< name used by other jobs to depend on this one, blank when not from a dag */
+		std::vector<uint32_t> deps_; /**< indexes of the jobs that have to finish successfully before this one can start */
+	};
+
+	CmdJobScheduler(const VecStr & cmds, uint32_t numThreads);
+
+	/**@brief Construct from a dag of commands
+	 *
+	 * Json should have a "jobs" array where each job has "name", "cmd" and optionally "deps" (names of other jobs)
+	 *
+	 * @param dagJson the dag
+	 * @param numThreads the number of thread slots
+	 */
+	CmdJobScheduler(const Json::Value & dagJson, uint32_t numThreads);
+
+	std::vector<Job> jobs_;
+	uint32_t numThreads_;
+
+	/**@brief Set cost of each command to the summed size of the files it references
+	 *
+	 * A job with dependencies costs at least its share of its dependencies' costs, since its inputs are normally written by them and don't exist before the run
+	 *
+	 */
+	void setCostsFromInputSizes();
+
+	/**@brief Set costs from the run times recorded in a runMultipleCommands log, commands not in the log are estimated from the matched commands
+	 *
+	 * @param logFnp the json log of a previous runMultipleCommands run
+	 * @return the number of commands that were found in the log
+	 */
+	uint32_t setCostsFromPreviousLog(const bfs::path & logFnp);
+
+	/**@brief Set the number of slots each command needs by looking for a thread flag in the command, capped at numThreads_
+	 *
+	 * @param threadFlag the flag that sets threads for the command
+	 */
+	void setThreadsFromCmds(const std::string & threadFlag = "--numThreads");
+
+	/**@brief Sort jobs into longest processing time first order, ties keep the input order
+	 *
+	 * When jobs have dependencies the cost of a job includes its most expensive chain of dependent jobs so the critical path starts first
+	 *
+	 */
+	void sortByCost();
+
+	/**@brief Simulate the schedule in the current job order
+	 *
+	 * @return the predicted makespan in the same units as the costs
+	 */
+	double predictMakespan() const;
+
+	/**@brief Run the commands in the current job order
+	 *
+	 * @param verbose print the commands as they are started
+	 * @return the outputs of the commands, in the original input order
+	 */
+	std::vector<bib::sys::RunOutput> run(bool verbose);
+
+	/**@brief Run the commands in the current job order, recording progress as each command starts and finishes
+	 *
+	 * @param verbose print the commands as they are started
+	 * @param ledger if not null, starts and finishes are appended to this ledger
+	 * @param progress print a summary of done/running/failed and an estimated time left after each command finishes
+	 * @return the outputs of the commands that were run, in the original input order, jobs skipped because a dependency failed are put in skipped_
+	 */
+	std::vector<bib::sys::RunOutput> run(bool verbose, CmdJobLedger * ledger,
+			bool progress);
+
+	/**@brief Remove the jobs that the ledger lists as already finished successfully, dependencies on removed jobs are treated as met
+	 *
+	 * @param ledger the ledger of a previous run
+	 * @return the number of jobs removed
+	 */
+	uint32_t removeFinished(const CmdJobLedger & ledger);
+
+	/**@brief Generate the json for a single dag job
+	 *
+	 * @param name the name of job
+	 * @param cmd the command to run
+	 * @param deps the names of the jobs that need to finish first
+	 * @return the json for the job, to be appended to the "jobs" array of a dag
+	 */
+	static Json::Value genDagJob(const std::string & name, const std::string & cmd,
+			const VecStr & deps);
+
+	Json::Value scheduleJson() const;
+
+	static std::vector<bfs::path> getInputFnpsFromCmd(const std::string & cmd);
+	static uint64_t getInputSizeFromCmd(const std::string & cmd);
+
+	std::vector<uint32_t> skipped_; /**< indexes of jobs that were not run because a dependency failed*/
+private:
+	void checkForCycles() const;
+
+	/**@brief Get the position in jobs_ of the next job that should start
+	 *
+	 * @param states the states of each job by index, 0=pending, 1=running, 2=succeeded, 3=failed or skipped
+	 * @param jobPos the position of the next job
+	 * @return 0 if no jobs left to start, 1 if jobPos was set, 2 if jobs are left but none of them have had their dependencies finish
+	 */
+	uint32_t getNextJob(std::vector<uint32_t> & states, uint32_t & jobPos) const;
+
+	uint32_t numIndexes_{0}; /**< the number of jobs constructed with, job indexes and dependencies stay below this after jobs are removed */
+
+
+};
+
+
+}  // namespace bibseq
+
+
+
@@ -0,0 +1,758 @@
+/*
+ * ParallelCollapser.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "ParallelCollapser.hpp"
+
+
+namespace bibseq {
+
+ParallelCollapser::ParallelCollapser(const CollapserOpts & opts,
+		uint32_t numThreads) :
+		opts_(opts), numThreads_(std::max<uint32_t>(numThreads, 1)) {
+}
+
+bool ParallelCollapser::canHandle(bool onPerId) const {
+	return !onPerId && !opts_.alignOpts_.noAlign_;
+}
+
+void ParallelCollapser::checkAlnPool(const concurrent::AlignerPool * alnPool,
+		const std::string & funcName) {
+	if (nullptr == alnPool) {
+		std::stringstream ss;
+		ss << funcName << ", error no aligner pool was given and singleAligner_ isn't set" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+}
+
+uint64_t ParallelCollapser::runOverPositions(uint32_t num,
+		concurrent::AlignerPool * alnPool,
+		const std::function<void(uint32_t, aligner &)> & func,
+		const std::function<void(aligner &)> & finishFunc) const {
+	return runOverPositions(num, numThreads_, singleAligner_, alnPool, func, finishFunc);
+}
+
+uint64_t ParallelCollapser::runOverPositions(uint32_t num, uint32_t numThreads,
+		aligner * singleAligner, concurrent::AlignerPool * alnPool,
+		const std::function<void(uint32_t, aligner &)> & func,
+		const std::function<void(aligner &)> & finishFunc) {
+	if (nullptr != singleAligner) {
+		auto startDone = singleAligner->numberOfAlingmentsDone_;
+		for (uint32_t pos = 0; pos < num; ++pos) {
+			func(pos, *singleAligner);
+		}
+		auto alignmentsDone = singleAligner->numberOfAlingmentsDone_ - startDone;
+		if (finishFunc) {
+			finishFunc(*singleAligner);
+		}
+		return alignmentsDone;
+	}
+	checkAlnPool(alnPool, __PRETTY_FUNCTION__);
+	std::atomic<uint32_t> nextPos { 0 };
+	std::atomic<uint64_t> alignmentsDone { 0 };
+	auto runPositions = [&alnPool, &nextPos, &num, &func, &finishFunc, &alignmentsDone]() {
+		auto currentAligner = alnPool->popAligner();
+		//pooled aligners keep their counts between uses so only count what's done here
+		auto startDone = currentAligner->numberOfAlingmentsDone_;
+		uint32_t pos = nextPos++;
+		while (pos < num) {
+			func(pos, *currentAligner);
+			pos = nextPos++;
+		}
+		alignmentsDone += currentAligner->numberOfAlingmentsDone_ - startDone;
+		if (finishFunc) {
+			finishFunc(*currentAligner);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < std::min(std::max<uint32_t>(numThreads, 1), std::max<uint32_t>(num, 1)); ++t) {
+		threads.emplace_back(std::thread(runPositions));
+	}
+	for (auto & t : threads) {
+		t.join();
+	}
+	return alignmentsDone;
+}
+
+ParallelCollapser::KmerProfile ParallelCollapser::genKmerProfile(
+		const std::string & seq, uint32_t kLen) {
+	if (0 == kLen || kLen > 32) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error k-mer length should be between 1 and 32, not " << kLen << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	KmerProfile ret;
+	ret.seqLen_ = seq.size();
+	if (seq.size() < kLen) {
+		return ret;
+	}
+	ret.kmers_.reserve(seq.size() - kLen + 1);
+	const uint64_t mask = 32 == kLen ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << (2 * kLen)) - 1;
+	uint64_t code = 0;
+	uint32_t validBases = 0;
+	for (const auto & base : seq) {
+		uint64_t baseCode = 0;
+		switch (base) {
+		case 'A':
+			baseCode = 0;
+			break;
+		case 'C':
+			baseCode = 1;
+			break;
+		case 'G':
+			baseCode = 2;
+			break;
+		case 'T':
+			baseCode = 3;
+			break;
+		default:
+			ret.ambiguous_ = true;
+			validBases = 0;
+			continue;
+		}
+		code = ((code << 2) | baseCode) & mask;
+		++validBases;
+		if (validBases >= kLen) {
+			ret.kmers_.emplace_back(code);
+		}
+	}
+	std::sort(ret.kmers_.begin(), ret.kmers_.end());
+	return ret;
+}
+
+bool ParallelCollapser::hasAmbiguousBases(const std::string & seq) {
+	return std::string::npos != seq.find_first_not_of("ACGT");
+}
+
+bool ParallelCollapser::kmersRuleOut(const KmerProfile & profile1,
+		const KmerProfile & profile2, uint32_t maxChangedKmers, uint32_t maxLenDiff) {
+	uint32_t lenDiff = std::max(profile1.seqLen_, profile2.seqLen_)
+			- std::min(profile1.seqLen_, profile2.seqLen_);
+	if (lenDiff > maxLenDiff) {
+		return true;
+	}
+	if (profile1.ambiguous_ || profile2.ambiguous_) {
+		return false;
+	}
+	//every k-mer the errors don't change is shared, so fewer shared than that means the errors can't pass
+	uint32_t mostKmers = std::max(profile1.kmers_.size(), profile2.kmers_.size());
+	return mostKmers > maxChangedKmers
+			&& sharedKmers(profile1, profile2) < mostKmers - maxChangedKmers;
+}
+
+uint32_t ParallelCollapser::sharedKmers(const KmerProfile & profile1,
+		const KmerProfile & profile2) {
+	uint32_t shared = 0;
+	auto iter1 = profile1.kmers_.begin();
+	auto iter2 = profile2.kmers_.begin();
+	while (iter1 != profile1.kmers_.end() && iter2 != profile2.kmers_.end()) {
+		if (*iter1 < *iter2) {
+			++iter1;
+		} else if (*iter2 < *iter1) {
+			++iter2;
+		} else {
+			++shared;
+			++iter1;
+			++iter2;
+		}
+	}
+	return shared;
+}
+
+bool ParallelCollapser::getPrefilterBounds(const comparison & allowed,
+		uint32_t & maxChangedKmers, uint32_t & maxLenDiff, uint32_t & maxEdits) const {
+	if (!opts_.alignOpts_.countEndGaps_ || opts_.iTOpts_.weighHomopolyer_
+			|| allowed.largeBaseIndel_ >= 1) {
+		return false;
+	}
+	//indels are whole counts when not weighing homopolymers so only the whole part of the allowed amount can be used
+	uint32_t oneBaseIndels = static_cast<uint32_t>(allowed.oneBaseIndel_);
+	uint32_t twoBaseIndels = static_cast<uint32_t>(allowed.twoBaseIndel_);
+	uint32_t mismatches = allowed.hqMismatches_ + allowed.lqMismatches_
+			+ allowed.lowKmerMismatches_;
+	maxChangedKmers = kmerPrefilterLength_ * (mismatches + oneBaseIndels)
+			+ (kmerPrefilterLength_ + 1) * twoBaseIndels;
+	maxLenDiff = oneBaseIndels + 2 * twoBaseIndels;
+	maxEdits = mismatches + maxLenDiff;
+	return true;
+}
+
+uint32_t ParallelCollapser::runClustering(std::vector<cluster> & clusters,
+		IncrementalCountOrder & countOrder, const IterPar & iterPar,
+		concurrent::AlignerPool * alnPool) {
+	//removes and count changes are only applied to the order at the end of the iteration
+	const auto & order = countOrder.getOrder();
+	//set up the k-mer prefilter for this iteration's clusters
+	uint32_t maxChangedKmers = 0;
+	uint32_t maxLenDiff = 0;
+	uint32_t maxEdits = 0;
+	bool canBound = (kmerPrefilter_ || editDistPrefilter_)
+			&& getPrefilterBounds(iterPar.errors_, maxChangedKmers, maxLenDiff, maxEdits);
+	bool usePrefilter = kmerPrefilter_ && canBound;
+	bool useEditPrefilter = editDistPrefilter_ && canBound;
+	if ((kmerPrefilter_ || editDistPrefilter_) && !canBound) {
+		++counts_.unfilteredIterations_;
+	}
+	std::vector<KmerProfile> profiles;
+	if (usePrefilter) {
+		profiles.resize(order.size());
+		runOverPositions(order.size(), alnPool,
+				[this, &clusters, &order, &profiles](uint32_t pos, aligner & alignerObj) {
+					profiles[pos] = genKmerProfile(clusters[order[pos]].seqBase_.seq_, kmerPrefilterLength_);
+				});
+	}
+	std::vector<std::unique_ptr<BitParallelEditDistance>> editProfiles;
+	if (useEditPrefilter) {
+		editProfiles.resize(order.size());
+		runOverPositions(order.size(), alnPool,
+				[&clusters, &order, &editProfiles](uint32_t pos, aligner & alignerObj) {
+					if (!hasAmbiguousBases(clusters[order[pos]].seqBase_.seq_)) {
+						editProfiles[pos] = std::make_unique<BitParallelEditDistance>(clusters[order[pos]].seqBase_.seq_);
+					}
+				});
+	}
+	std::atomic<uint64_t> aligned { 0 };
+	std::atomic<uint64_t> skipped { 0 };
+	std::atomic<uint64_t> editSkipped { 0 };
+	std::atomic<uint64_t> cachedFailures { 0 };
+	//a pair that failed before fails again under the same allowed errors unless one of the clusters has changed since
+	++iterationNumber_;
+	if (cacheFailedComparisons_) {
+		auto errorsKey = iterPar.errors_.toJson().toStyledString();
+		if (errorsKey != failedPairsErrors_) {
+			failedPairs_.clear();
+			failedPairsErrors_ = errorsKey;
+		}
+	}
+	std::vector<std::vector<uint64_t>> newFailedPairs(cacheFailedComparisons_ ? order.size() : 0);
+	//find matches, only against the clusters as they are at the start of the iteration so the order the threads finish in doesn't matter
+	std::vector<int64_t> matches(order.size(), -1);
+	counts_.alignmentsDone_ += runOverPositions(order.size(), alnPool,
+			[this, &clusters, &order, &iterPar, &matches, &usePrefilter, &profiles,
+			 &maxChangedKmers, &maxLenDiff, &aligned, &skipped, &useEditPrefilter,
+			 &editProfiles, &maxEdits, &editSkipped, &cachedFailures,
+			 &newFailedPairs](uint32_t readPos, aligner & alignerObj) {
+				const auto & read = clusters[order[readPos]];
+				uint32_t checked = 0;
+				for (uint32_t clusPos = 0; clusPos < readPos; ++clusPos) {
+					const auto & clus = clusters[order[clusPos]];
+					//two small clusters aren't collapsed together
+					if (clus.seqBase_.cnt_ <= iterPar.smallCheckStop_
+							&& read.seqBase_.cnt_ <= iterPar.smallCheckStop_) {
+						continue;
+					}
+					++checked;
+					if (checked > iterPar.stopCheck_) {
+						break;
+					}
+					if (usePrefilter
+							&& kmersRuleOut(profiles[clusPos], profiles[readPos], maxChangedKmers, maxLenDiff)) {
+						++skipped;
+						continue;
+					}
+					//any alignment has at least as many mismatches plus indel bases as the edit distance, clusters with ambiguous bases have no edit profile
+					if (useEditPrefilter
+							&& nullptr != editProfiles[clusPos]
+							&& nullptr != editProfiles[readPos]
+							&& editProfiles[clusPos]->distance(read.seqBase_.seq_) > maxEdits) {
+						++editSkipped;
+						continue;
+					}
+					uint64_t pairKey = 0;
+					if (cacheFailedComparisons_) {
+						pairKey = (static_cast<uint64_t>(order[clusPos]) << 32) | order[readPos];
+						auto failed = failedPairs_.find(pairKey);
+						if (failedPairs_.end() != failed
+								&& failed->second > changedIteration_[order[clusPos]]
+								&& failed->second > changedIteration_[order[readPos]]) {
+							++cachedFailures;
+							continue;
+						}
+					}
+					++aligned;
+					alignerObj.alignCacheGlobal(clus, read);
+					alignerObj.profileAlignment(clus, read, opts_.kmerOpts_.checkKmers_, true, false);
+					if (iterPar.errors_.passErrorProfile(alignerObj.comp_)) {
+						matches[readPos] = clusPos;
+						break;
+					}
+					if (cacheFailedComparisons_) {
+						newFailedPairs[readPos].emplace_back(pairKey);
+					}
+				}
+			});
+	counts_.aligned_ += aligned;
+	counts_.skipped_ += skipped;
+	counts_.editSkipped_ += editSkipped;
+	counts_.cachedFailures_ += cachedFailures;
+	for (const auto & readFailedPairs : newFailedPairs) {
+		for (const auto & pairKey : readFailedPairs) {
+			failedPairs_[pairKey] = iterationNumber_;
+		}
+	}
+	//apply merges from the least abundant up so a cluster that is itself merged takes what was merged into it along
+	std::vector<uint32_t> needsConsensus;
+	std::vector<bool> received(order.size(), false);
+	uint32_t merged = 0;
+	for (const auto readPos : iter::range(order.size())) {
+		auto pos = order.size() - 1 - readPos;
+		if (matches[pos] < 0) {
+			continue;
+		}
+		auto & mergedClus = clusters[order[pos]];
+		clusters[order[matches[pos]]].addRead(mergedClus);
+		mergedClus.remove = true;
+		countOrder.remove(order[pos]);
+		//its reads now belong to the cluster it was merged into, release what's no longer needed
+		mergedClus.reads_ = std::vector<std::shared_ptr<readObject>>();
+		mergedClus.seqBase_ = seqInfo();
+		received[matches[pos]] = true;
+		++merged;
+	}
+	for (const auto pos : iter::range(order.size())) {
+		if (received[pos] && !clusters[order[pos]].remove) {
+			needsConsensus.emplace_back(order[pos]);
+			countOrder.setCount(order[pos], clusters[order[pos]].seqBase_.cnt_);
+			changedIteration_[order[pos]] = iterationNumber_;
+		}
+	}
+	counts_.consensusAlignmentsDone_ += runOverPositions(needsConsensus.size(), alnPool,
+			[&clusters, &needsConsensus](uint32_t pos, aligner & alignerObj) {
+				clusters[needsConsensus[pos]].calculateConsensus(alignerObj, true);
+			});
+	//only the clusters whose counts changed move, rather than re-sorting every position
+	countOrder.getOrder();
+	return merged;
+}
+
+void ParallelCollapser::runFullClustering(std::vector<cluster> & clusters,
+		const CollapseIterations & iteratorMap,
+		concurrent::AlignerPool * alnPool) {
+	//sort and split positions rather than the clusters so each cluster is only copied once, when building the final vector
+	IncrementalCountOrder countOrder(clusters);
+	const auto & order = countOrder.getOrder();
+	//cluster positions only mean the same clusters within one call
+	failedPairs_.clear();
+	failedPairsErrors_.clear();
+	changedIteration_.assign(clusters.size(), 0);
+	iterationNumber_ = 0;
+	for (const auto & iter : iteratorMap.iters_) {
+		uint32_t merged = 0;
+		uint32_t rerun = 0;
+		do {
+			auto startingSize = order.size();
+			merged = runClustering(clusters, countOrder, iter.second, alnPool);
+			if (opts_.verboseOpts_.verbose_) {
+				std::cout << "Iteration " << iter.first << ": collapsed "
+						<< startingSize << " clusters down to " << order.size()
+						<< std::endl;
+			}
+			if (nullptr != snapshots_) {
+				snapshots_->capture(snapshotsDirName_,
+						estd::to_string(iter.first) + (rerun > 0 ? "." + estd::to_string(rerun) : ""),
+						clusters, order);
+			}
+			++rerun;
+		} while (opts_.clusOpts_.converge_ && merged > 0);
+	}
+	std::vector<cluster> collapsed;
+	collapsed.reserve(order.size());
+	for (const auto & clusPos : order) {
+		collapsed.emplace_back(std::move(clusters[clusPos]));
+	}
+	clusters.swap(collapsed);
+	clusterVec::allSetFractionClusters(clusters);
+}
+
+uint32_t ParallelCollapser::mapBackSinglets(std::vector<cluster> & clusters,
+		std::vector<cluster> & singlets, const IterPar & iterPar,
+		const CollapseIterations & residualIteratorMap,
+		concurrent::AlignerPool * alnPool) {
+	//index the clusters by their k-mers, each cluster is listed once per distinct k-mer
+	std::vector<KmerProfile> clusProfiles(clusters.size());
+	runOverPositions(clusters.size(), alnPool,
+			[this, &clusters, &clusProfiles](uint32_t pos, aligner & alignerObj) {
+				clusProfiles[pos] = genKmerProfile(clusters[pos].seqBase_.seq_, kmerPrefilterLength_);
+			});
+	std::unordered_map<uint64_t, std::vector<uint32_t>> kmerIndex;
+	for (const auto clusPos : iter::range<uint32_t>(clusters.size())) {
+		const auto & kmers = clusProfiles[clusPos].kmers_;
+		for (const auto kPos : iter::range(kmers.size())) {
+			if (0 == kPos || kmers[kPos] != kmers[kPos - 1]) {
+				kmerIndex[kmers[kPos]].emplace_back(clusPos);
+			}
+		}
+	}
+	uint32_t maxChangedKmers = 0;
+	uint32_t maxLenDiff = 0;
+	uint32_t maxEdits = 0;
+	bool canBound = getPrefilterBounds(iterPar.errors_, maxChangedKmers, maxLenDiff, maxEdits);
+	std::atomic<uint64_t> aligned { 0 };
+	std::atomic<uint64_t> skipped { 0 };
+	std::vector<int64_t> matches(singlets.size(), -1);
+	counts_.alignmentsDone_ += runOverPositions(singlets.size(), alnPool,
+			[this, &clusters, &singlets, &iterPar, &matches, &clusProfiles, &kmerIndex,
+			 &canBound, &maxChangedKmers, &maxLenDiff, &aligned, &skipped](uint32_t singPos, aligner & alignerObj) {
+				const auto & singlet = singlets[singPos];
+				auto singProfile = genKmerProfile(singlet.seqBase_.seq_, kmerPrefilterLength_);
+				std::unordered_map<uint32_t, uint32_t> sharedCounts;
+				const auto & kmers = singProfile.kmers_;
+				for (const auto kPos : iter::range(kmers.size())) {
+					if (0 != kPos && kmers[kPos] == kmers[kPos - 1]) {
+						continue;
+					}
+					auto search = kmerIndex.find(kmers[kPos]);
+					if (kmerIndex.end() != search) {
+						for (const auto & clusPos : search->second) {
+							++sharedCounts[clusPos];
+						}
+					}
+				}
+				//most shared k-mers first, then most abundant, then input order
+				std::vector<std::pair<uint32_t, uint32_t>> candidates(sharedCounts.begin(), sharedCounts.end());
+				std::sort(candidates.begin(), candidates.end(),
+						[&clusters](const std::pair<uint32_t, uint32_t> & cand1, const std::pair<uint32_t, uint32_t> & cand2) {
+							if (cand1.second != cand2.second) {
+								return cand1.second > cand2.second;
+							}
+							if (clusters[cand1.first].seqBase_.cnt_ != clusters[cand2.first].seqBase_.cnt_) {
+								return clusters[cand1.first].seqBase_.cnt_ > clusters[cand2.first].seqBase_.cnt_;
+							}
+							return cand1.first < cand2.first;
+						});
+				uint32_t checked = 0;
+				for (const auto & cand : candidates) {
+					++checked;
+					if (checked > iterPar.stopCheck_) {
+						break;
+					}
+					if (canBound
+							&& kmersRuleOut(clusProfiles[cand.first], singProfile, maxChangedKmers, maxLenDiff)) {
+						++skipped;
+						continue;
+					}
+					++aligned;
+					const auto & clus = clusters[cand.first];
+					alignerObj.alignCacheGlobal(clus, singlet);
+					alignerObj.profileAlignment(clus, singlet, opts_.kmerOpts_.checkKmers_, true, false);
+					if (iterPar.errors_.passErrorProfile(alignerObj.comp_)) {
+						matches[singPos] = cand.first;
+						break;
+					}
+				}
+			});
+	counts_.aligned_ += aligned;
+	counts_.skipped_ += skipped;
+	std::vector<bool> received(clusters.size(), false);
+	std::vector<cluster> residual;
+	uint32_t mapped = 0;
+	for (const auto singPos : iter::range(singlets.size())) {
+		if (matches[singPos] < 0) {
+			residual.emplace_back(std::move(singlets[singPos]));
+		} else {
+			clusters[matches[singPos]].addRead(singlets[singPos]);
+			received[matches[singPos]] = true;
+			++mapped;
+		}
+	}
+	singlets.clear();
+	std::vector<uint32_t> needsConsensus;
+	for (const auto clusPos : iter::range<uint32_t>(clusters.size())) {
+		if (received[clusPos]) {
+			needsConsensus.emplace_back(clusPos);
+		}
+	}
+	counts_.consensusAlignmentsDone_ += runOverPositions(needsConsensus.size(), alnPool,
+			[&clusters, &needsConsensus](uint32_t pos, aligner & alignerObj) {
+				clusters[needsConsensus[pos]].calculateConsensus(alignerObj, true);
+			});
+	if (opts_.verboseOpts_.verbose_) {
+		std::cout << "Mapped " << mapped << " singlets back to clusters, collapsing the other "
+				<< residual.size() << std::endl;
+	}
+	if (!residual.empty()) {
+		//the residual singlets on their own aren't a snapshot of the clustering, only the combined result is captured
+		auto snapshots = snapshots_;
+		snapshots_ = nullptr;
+		runFullClustering(residual, residualIteratorMap, alnPool);
+		snapshots_ = snapshots;
+		for (auto & clus : residual) {
+			clusters.emplace_back(std::move(clus));
+		}
+	}
+	ClusterSortOrder::applyOrder(clusters, ClusterSortOrder::genOrder(clusters,
+			[](const cluster & clus1, const cluster & clus2) {
+				return clus1.seqBase_.cnt_ > clus2.seqBase_.cnt_;
+			}));
+	clusterVec::allSetFractionClusters(clusters);
+	if (nullptr != snapshots_) {
+		snapshots_->capture(snapshotsDirName_, "mapBackSinglets", clusters);
+	}
+	return mapped;
+}
+
+std::vector<std::vector<uint32_t>> ParallelCollapser::genBins(
+		const std::vector<cluster> & clusters, double nucCompCutOff) const {
+	//bins are started by the most abundant clusters
+	std::vector<uint32_t> byCount(clusters.size());
+	std::iota(byCount.begin(), byCount.end(), 0);
+	std::stable_sort(byCount.begin(), byCount.end(),
+			[&clusters](uint32_t clusPos1, uint32_t clusPos2) {
+				return clusters[clusPos1].seqBase_.cnt_ > clusters[clusPos2].seqBase_.cnt_;
+			});
+	std::vector<std::vector<uint32_t>> bins;
+	if (opts_.nucCompBinOpts_.useNucComp_) {
+		//optionally only compare the composition of the bases all clusters have
+		uint64_t compLen = std::numeric_limits<uint64_t>::max();
+		if (opts_.nucCompBinOpts_.useMinLenNucComp_) {
+			for (const auto & clus : clusters) {
+				compLen = std::min<uint64_t>(compLen, clus.seqBase_.seq_.size());
+			}
+		}
+		auto genComp = [&compLen](const std::string & seq) {
+			std::array<double, 4> comp { { 0, 0, 0, 0 } };
+			uint64_t len = std::min<uint64_t>(seq.size(), compLen);
+			for (uint64_t pos = 0; pos < len; ++pos) {
+				switch (seq[pos]) {
+				case 'A':
+					++comp[0];
+					break;
+				case 'C':
+					++comp[1];
+					break;
+				case 'G':
+					++comp[2];
+					break;
+				case 'T':
+					++comp[3];
+					break;
+				default:
+					break;
+				}
+			}
+			if (len > 0) {
+				for (auto & frac : comp) {
+					frac /= len;
+				}
+			}
+			return comp;
+		};
+		std::vector<std::array<double, 4>> binComps;
+		for (const auto & clusPos : byCount) {
+			auto comp = genComp(clusters[clusPos].seqBase_.seq_);
+			int64_t bestBin = -1;
+			double bestDiff = std::numeric_limits<double>::max();
+			for (const auto binPos : iter::range(binComps.size())) {
+				double diff = 0;
+				for (const auto base : iter::range(comp.size())) {
+					diff += std::abs(comp[base] - binComps[binPos][base]);
+				}
+				if (diff <= nucCompCutOff && diff < bestDiff) {
+					bestBin = binPos;
+					bestDiff = diff;
+					if (!opts_.nucCompBinOpts_.findBestNuc_) {
+						break;
+					}
+				}
+			}
+			if (bestBin < 0) {
+				binComps.emplace_back(comp);
+				bins.emplace_back(std::vector<uint32_t>{clusPos});
+			} else {
+				bins[bestBin].emplace_back(clusPos);
+			}
+		}
+	} else if (opts_.kmerBinOpts_.useKmerBinning_) {
+		std::vector<KmerProfile> binProfiles;
+		for (const auto & clusPos : byCount) {
+			auto profile = genKmerProfile(clusters[clusPos].seqBase_.seq_,
+					opts_.kmerBinOpts_.kCompareLen_);
+			int64_t foundBin = -1;
+			for (const auto binPos : iter::range(binProfiles.size())) {
+				uint32_t mostKmers = std::max(profile.kmers_.size(), binProfiles[binPos].kmers_.size());
+				if (mostKmers > 0
+						&& static_cast<double>(sharedKmers(profile, binProfiles[binPos])) / mostKmers
+								>= opts_.kmerBinOpts_.kmerCutOff_) {
+					foundBin = binPos;
+					break;
+				}
+			}
+			if (foundBin < 0) {
+				binProfiles.emplace_back(profile);
+				bins.emplace_back(std::vector<uint32_t>{clusPos});
+			} else {
+				bins[foundBin].emplace_back(clusPos);
+			}
+		}
+	} else if (!clusters.empty()) {
+		bins.emplace_back(byCount);
+	}
+	return bins;
+}
+
+void ParallelCollapser::runBinnedClustering(std::vector<cluster> & clusters,
+		const CollapseIterations & binIteratorMap,
+		const CollapseIterations & iteratorMap,
+		concurrent::AlignerPool * alnPool) {
+	//the cut offs only matter when binning by nucleotide composition, otherwise the bins are formed once
+	std::vector<double> nucCompCutOffs { 0.1 };
+	if (opts_.nucCompBinOpts_.useNucComp_ && !opts_.nucCompBinOpts_.diffCutOffVec_.empty()) {
+		nucCompCutOffs = opts_.nucCompBinOpts_.diffCutOffVec_;
+	}
+	for (const auto & nucCompCutOff : nucCompCutOffs) {
+		collapseBins(clusters, genBins(clusters, nucCompCutOff), binIteratorMap, alnPool);
+		if (!opts_.nucCompBinOpts_.useNucComp_) {
+			break;
+		}
+	}
+	if (nullptr != snapshots_) {
+		snapshots_->capture(snapshotsDirName_, "bins", clusters);
+	}
+	runFullClustering(clusters, iteratorMap, alnPool);
+}
+
+void ParallelCollapser::collapseBins(std::vector<cluster> & clusters,
+		const std::vector<std::vector<uint32_t>> & binPositions,
+		const CollapseIterations & binIteratorMap,
+		concurrent::AlignerPool * alnPool) {
+	std::vector<std::vector<cluster>> bins(binPositions.size());
+	for (const auto binPos : iter::range(binPositions.size())) {
+		bins[binPos].reserve(binPositions[binPos].size());
+		for (const auto & clusPos : binPositions[binPos]) {
+			bins[binPos].emplace_back(std::move(clusters[clusPos]));
+		}
+	}
+	if (opts_.verboseOpts_.verbose_) {
+		std::cout << "Collapsing " << clusters.size() << " clusters in "
+				<< bins.size() << " bins" << std::endl;
+	}
+	//a bin's comparisons grow with its size squared so the largest bins are started first
+	std::vector<uint32_t> binOrder(bins.size());
+	std::iota(binOrder.begin(), binOrder.end(), 0);
+	std::stable_sort(binOrder.begin(), binOrder.end(),
+			[&bins](uint32_t binPos1, uint32_t binPos2) {
+				return bins[binPos1].size() > bins[binPos2].size();
+			});
+	if (nullptr == singleAligner_) {
+		checkAlnPool(alnPool, __PRETTY_FUNCTION__);
+	}
+	bib::concurrent::LockableQueue<uint32_t> binQueue(binOrder);
+	std::mutex countsMut;
+	auto collapseBins = [this,&binQueue,&bins,&binIteratorMap,&alnPool,&countsMut](){
+		//on one thread the bins are collapsed on the single aligner rather than a pooled one
+		decltype(alnPool->popAligner()) pooledAligner;
+		aligner * binAligner = singleAligner_;
+		if (nullptr == binAligner) {
+			pooledAligner = alnPool->popAligner();
+			binAligner = pooledAligner.get();
+		}
+		uint32_t binPos = 0;
+		while (binQueue.getVal(binPos)) {
+			ParallelCollapser binCollapser(opts_, 1);
+			binCollapser.opts_.verboseOpts_.verbose_ = false;
+			binCollapser.kmerPrefilter_ = kmerPrefilter_;
+			binCollapser.kmerPrefilterLength_ = kmerPrefilterLength_;
+			binCollapser.editDistPrefilter_ = editDistPrefilter_;
+			binCollapser.cacheFailedComparisons_ = cacheFailedComparisons_;
+			binCollapser.singleAligner_ = binAligner;
+			binCollapser.runFullClustering(bins[binPos], binIteratorMap, alnPool);
+			std::lock_guard<std::mutex> lock(countsMut);
+			counts_.aligned_ += binCollapser.counts_.aligned_;
+			counts_.alignmentsDone_ += binCollapser.counts_.alignmentsDone_;
+			counts_.consensusAlignmentsDone_ += binCollapser.counts_.consensusAlignmentsDone_;
+			counts_.skipped_ += binCollapser.counts_.skipped_;
+			counts_.editSkipped_ += binCollapser.counts_.editSkipped_;
+			counts_.cachedFailures_ += binCollapser.counts_.cachedFailures_;
+			counts_.unfilteredIterations_ += binCollapser.counts_.unfilteredIterations_;
+		}
+	};
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < std::min<uint32_t>(numThreads_, bins.size()); ++t) {
+		threads.emplace_back(std::thread(collapseBins));
+	}
+	for (auto & t : threads) {
+		t.join();
+	}
+	clusters.clear();
+	for (auto & bin : bins) {
+		for (auto & clus : bin) {
+			clusters.emplace_back(std::move(clus));
+		}
+	}
+}
+
+uint64_t ParallelCollapser::cacheChimeraAlignments(
+		const std::vector<cluster> & clusters, double parentFreqs,
+		aligner & alignerObj, concurrent::AlignerPool * alnPool) const {
+	std::mutex cacheMut;
+	uint64_t added = 0;
+	runOverPositions(clusters.size(), alnPool,
+			[&clusters, &parentFreqs](uint32_t childPos, aligner & threadAligner) {
+				const auto & child = clusters[childPos];
+				for (const auto parentPos : iter::range(clusters.size())) {
+					if (parentPos != childPos
+							&& clusters[parentPos].seqBase_.cnt_ >= child.seqBase_.cnt_ * parentFreqs) {
+						threadAligner.alignCacheGlobal(clusters[parentPos], child);
+					}
+				}
+			},
+			[&alignerObj, &cacheMut, &added](aligner & threadAligner) {
+				std::lock_guard<std::mutex> lock(cacheMut);
+				added += addNewAlignments(threadAligner, alignerObj);
+			});
+	alignerObj.numberOfAlingmentsDone_ += added;
+	return added;
+}
+
+namespace {
+template<typename HOLDERS>
+uint64_t addNewHolderAlignments(const HOLDERS & threadHolders, HOLDERS & mainHolders) {
+	uint64_t added = 0;
+	for (const auto & holder : threadHolders) {
+		auto & mainHolder = mainHolders[holder.first];
+		for (const auto & seqAInfos : holder.second.infos_) {
+			auto & mainSeqAInfos = mainHolder.infos_[seqAInfos.first];
+			for (const auto & seqBInfo : seqAInfos.second) {
+				if (mainSeqAInfos.emplace(seqBInfo.first, seqBInfo.second).second) {
+					++added;
+				}
+			}
+		}
+	}
+	return added;
+}
+}  // namespace
+
+uint64_t ParallelCollapser::addNewAlignments(const aligner & threadAligner,
+		aligner & alignerObj) {
+	//the thread's aligner started as a copy of alignerObj so only alignments alignerObj lacks are new
+	return addNewHolderAlignments(threadAligner.alnHolder_.globalHolder_,
+			alignerObj.alnHolder_.globalHolder_)
+			+ addNewHolderAlignments(threadAligner.alnHolder_.localHolder_,
+					alignerObj.alnHolder_.localHolder_);
+}
+
+}  // namespace bibseq
@@ -0,0 +1,306 @@
+#pragma once
+/*
+ * ParallelCollapser.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+#include "SeekDeep/objects/SnapshotWriter.hpp"
+#include "SeekDeep/objects/ClusterSortOrder.hpp"
+#include "SeekDeep/objects/BitParallelEditDistance.hpp"
+
+
+namespace bibseq {
+
+/**@brief Run the iterative collapsing done by collapser::runFullClustering with the comparisons spread over several threads
+ *
+ * Each iteration first finds a match for every cluster against the clusters as they were at the start of the iteration (in parallel, one aligner per thread),
+ * and then applies the merges from the least abundant cluster up and rebuilds consensus sequences,
+ * so the results are the same regardless of the number of threads, they are not the same as collapser::runFullClustering's
+ * which merges each cluster as soon as it finds a match and can pick the best of several matches,
+ * optionally comparisons whose k-mer counts or edit distance show they can't pass the iteration's allowed errors are skipped without aligning,
+ * when binning clusters first the bins are collapsed at the same time, each on its own aligner,
+ * since the clusters can differ qluster only uses it when asked to with --parallelCollapse
+ *
+ */
+class ParallelCollapser {
+public:
+
+	ParallelCollapser(const CollapserOpts & opts, uint32_t numThreads);
+
+	CollapserOpts opts_;
+	uint32_t numThreads_;
+
+	bool kmerPrefilter_{false}; /**< skip aligning clusters when their shared k-mer count proves they can't pass the allowed errors */
+	uint32_t kmerPrefilterLength_{8}; /**< k-mer length for the prefilter, at most 32 */
+	bool editDistPrefilter_{false}; /**< skip aligning clusters when their bit-parallel edit distance is more than the allowed errors, not used for clusters with bases other than ACGT */
+	bool cacheFailedComparisons_{false}; /**< skip re-aligning pairs that failed under the same allowed errors when neither cluster has changed since */
+	aligner * singleAligner_{nullptr}; /**< when set everything is run on this aligner on the calling thread and the aligner pools aren't used, for running on one thread or collapsing a single bin */
+	SnapshotWriter * snapshots_{nullptr}; /**< when set the clusters are captured after every iteration, bins are only captured once they're all collapsed */
+	std::string snapshotsDirName_{"snapShots"}; /**< the directory the captures go in within the writer's output directory */
+
+	struct ComparisonCounts {
+		uint64_t aligned_{0}; /**< comparisons that were aligned */
+		uint64_t alignmentsDone_{0}; /**< of aligned_, the comparisons that weren't already in the alignment cache */
+		uint64_t consensusAlignmentsDone_{0}; /**< alignments computed while rebuilding the consensus of clusters that took in reads */
+		uint64_t skipped_{0}; /**< comparisons skipped by the k-mer prefilter */
+		uint64_t editSkipped_{0}; /**< comparisons skipped by the edit distance prefilter */
+		uint64_t cachedFailures_{0}; /**< comparisons skipped because they already failed under the same allowed errors and neither cluster changed */
+		uint32_t unfilteredIterations_{0}; /**< iterations that allowed errors the prefilters can't bound (large indels, homopolymer weighting or uncounted end gaps) */
+	};
+	ComparisonCounts counts_;
+
+	/**@brief The k-mers of a sequence packed 2 bits a base and sorted, k-mers with bases other than ACGT are left out
+	 *
+	 */
+	struct KmerProfile {
+		std::vector<uint64_t> kmers_;
+		uint32_t seqLen_{0};
+		bool ambiguous_{false}; /**< the sequence has bases other than ACGT so its k-mers can't bound its errors */
+	};
+
+	static KmerProfile genKmerProfile(const std::string & seq, uint32_t kLen);
+
+	/**@brief Whether a sequence has bases other than ACGT, which the aligner can score as matching so the prefilters can't bound comparisons with it
+	 *
+	 */
+	static bool hasAmbiguousBases(const std::string & seq);
+
+	/**@brief Whether the k-mer profiles prove the sequences can't pass errors that change at most maxChangedKmers k-mers and maxLenDiff of the length
+	 *
+	 * Only the length difference is checked when either sequence has bases other than ACGT,
+	 * since a k-mer with an N can match any k-mer in the aligner the shared k-mer count is too low a bound
+	 *
+	 * @return true if the comparison can be skipped
+	 */
+	static bool kmersRuleOut(const KmerProfile & profile1,
+			const KmerProfile & profile2, uint32_t maxChangedKmers, uint32_t maxLenDiff);
+
+	/**@brief Count the k-mers shared by two profiles, counting repeated k-mers as many times as they occur in both
+	 *
+	 */
+	static uint32_t sharedKmers(const KmerProfile & profile1,
+			const KmerProfile & profile2);
+
+	/**@brief Get how many k-mers the allowed errors can change in either sequence
+	 *
+	 * A mismatch or one base indel changes at most k k-mers and a two base indel at most k + 1,
+	 * large indels, homopolymer weighted indels and uncounted end gaps can change any number so they can't be bounded
+	 *
+	 * @param allowed the allowed errors
+	 * @param maxChangedKmers the number of k-mers that can be changed
+	 * @param maxLenDiff the largest length difference the allowed indels can account for
+	 * @param maxEdits the most mismatches plus indel bases the allowed errors can account for
+	 * @return whether the allowed errors could be bounded
+	 */
+	bool getPrefilterBounds(const comparison & allowed, uint32_t & maxChangedKmers,
+			uint32_t & maxLenDiff, uint32_t & maxEdits) const;
+
+	/**@brief Whether the options can be run by this collapser, otherwise collapser::runFullClustering should be used
+	 *
+	 * Percent identity clustering and comparing without aligning are only handled by collapser
+	 *
+	 * @param onPerId whether clustering on percent identity
+	 * @return true if this collapser can be used
+	 */
+	bool canHandle(bool onPerId) const;
+
+	/**@brief Collapse the clusters with each iteration in the iterator map
+	 *
+	 * @param clusters the clusters to collapse, on return holds the collapsed clusters sorted by count
+	 * @param iteratorMap the iterations with the errors to allow
+	 * @param alnPool the aligners to use, one is popped per thread, can be nullptr when singleAligner_ is set
+	 */
+	void runFullClustering(std::vector<cluster> & clusters,
+			const CollapseIterations & iteratorMap,
+			concurrent::AlignerPool * alnPool);
+
+	/**@brief Collapse each bin of clusters with binIteratorMap and then collapse all the bins' clusters together with iteratorMap
+	 *
+	 * Bins are collapsed at the same time, each on its own aligner with the threads taking the next bin as they finish,
+	 * bins are started largest first since the comparisons in a bin grow with its size squared,
+	 * when binning by nucleotide composition with several cut offs the clusters are re-binned and the bins collapsed again for each cut off in order
+	 *
+	 * @param clusters the clusters to collapse, on return holds the collapsed clusters sorted by count
+	 * @param binIteratorMap the iterations to run within each bin
+	 * @param iteratorMap the iterations to run on all the clusters once the bins are done
+	 * @param alnPool the aligners to use, one is popped per thread, can be nullptr when singleAligner_ is set
+	 */
+	void runBinnedClustering(std::vector<cluster> & clusters,
+			const CollapseIterations & binIteratorMap,
+			const CollapseIterations & iteratorMap,
+			concurrent::AlignerPool * alnPool);
+
+	/**@brief Add singlets to the already collapsed clusters by comparing each singlet only to the clusters it shares the most k-mers with
+	 *
+	 * The clusters are indexed by their k-mers (of kmerPrefilterLength_), each singlet is aligned against up to iterPar.stopCheck_ clusters
+	 * in order of most shared k-mers and goes into the first one that passes iterPar's errors, the singlets are matched in parallel against the clusters as they are before any are added
+	 *
+	 * @param clusters the collapsed clusters, on return includes the singlets that matched and the collapsed singlets that didn't, sorted by count
+	 * @param singlets the singlets to add, emptied on return
+	 * @param iterPar the errors to allow, normally the last iteration's
+	 * @param residualIteratorMap the iterations used to collapse the singlets that didn't match a cluster
+	 * @param alnPool the aligners to use, one is popped per thread, can be nullptr when singleAligner_ is set
+	 * @return the number of singlets that matched a cluster
+	 */
+	uint32_t mapBackSinglets(std::vector<cluster> & clusters,
+			std::vector<cluster> & singlets, const IterPar & iterPar,
+			const CollapseIterations & residualIteratorMap,
+			concurrent::AlignerPool * alnPool);
+
+	/**@brief Split clusters into bins by nucleotide composition (opts_.nucCompBinOpts_) or shared k-mers (opts_.kmerBinOpts_)
+	 *
+	 * Going from the most abundant cluster down, each cluster joins the first bin (or with findBestNuc_ the closest bin) whose first cluster is within the cut off
+	 * otherwise it starts a new bin, with neither binning option set all clusters are put in one bin
+	 *
+	 * @param clusters the clusters to bin
+	 * @param nucCompCutOff the largest summed difference in base fractions for a cluster to join a bin when binning by nucleotide composition
+	 * @return the positions in clusters of the clusters in each bin
+	 */
+	std::vector<std::vector<uint32_t>> genBins(const std::vector<cluster> & clusters,
+			double nucCompCutOff) const;
+
+	/**@brief Run one iteration of collapsing
+	 *
+	 * The clusters themselves are never moved or copied, only order is sorted and shrunk,
+	 * clusters merged into another are marked remove and have their sequence and reads released
+	 *
+	 * @param clusters the clusters
+	 * @param countOrder the positions in clusters of the clusters still being collapsed kept by count, updated as clusters are merged
+	 * @param iterPar the errors to allow
+	 * @param alnPool the aligners to use, can be nullptr when singleAligner_ is set
+	 * @return the number of clusters that were merged into another cluster
+	 */
+	uint32_t runClustering(std::vector<cluster> & clusters,
+			IncrementalCountOrder & countOrder, const IterPar & iterPar,
+			concurrent::AlignerPool * alnPool);
+
+	/**@brief Do the alignments collapser::markChimeras will ask for, spread over the threads, and add them to alignerObj's cache
+	 *
+	 * Every cluster is aligned against each other cluster at least parentFreqs times as abundant, so markChimeras itself only reads from the cache
+	 * and its results are the same as when run on its own
+	 *
+	 * @param clusters the clusters that will be checked for chimeras
+	 * @param parentFreqs how many times more abundant a parent has to be
+	 * @param alignerObj the aligner that will be used to mark chimeras
+	 * @param alnPool the aligners to use, should have been made from alignerObj
+	 * @return the number of alignments added to alignerObj's cache
+	 */
+	uint64_t cacheChimeraAlignments(const std::vector<cluster> & clusters,
+			double parentFreqs, aligner & alignerObj,
+			concurrent::AlignerPool * alnPool) const;
+
+	/**@brief Align every cluster against every reference sequence ahead of time, spread over the threads, and add the alignments to alignerObj's cache
+	 *
+	 * The reference comparisons (profiler::getFractionInfoCluster with a reference file, checkAgainstExpected, comparePopToRefSeqs)
+	 * align each cluster to every reference with alignerObj on one thread, with the alignments cached they only look them up
+	 * and still pick the best matches themselves so the assignments are unchanged,
+	 * they align with the reference as the first sequence so the alignments are cached the same way round
+	 *
+	 * @param clusters the clusters that will be compared to the references
+	 * @param refSeqs the reference sequences
+	 * @param local whether the comparisons use local alignments
+	 * @param alignerObj the aligner that will be used for the comparisons
+	 * @param alnPool the aligners to use, should have been made from alignerObj
+	 * @param numThreads the number of threads to use, at most the number of aligners in alnPool
+	 * @return the number of alignments added to alignerObj's cache
+	 */
+	template<typename CLUSTER>
+	static uint64_t cacheReferenceAlignments(const std::vector<CLUSTER> & clusters,
+			const std::vector<readObject> & refSeqs, bool local, aligner & alignerObj,
+			concurrent::AlignerPool & alnPool, uint32_t numThreads) {
+		uint64_t numPairs = static_cast<uint64_t>(clusters.size()) * refSeqs.size();
+		if (numPairs > std::numeric_limits<uint32_t>::max()) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error can only cache up to "
+					<< std::numeric_limits<uint32_t>::max() << " cluster and reference pairs, not " << numPairs << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		std::mutex cacheMut;
+		uint64_t added = 0;
+		//spread over the pairs rather than the clusters so a few clusters against many references still use every thread
+		runOverPositions(numPairs, numThreads, nullptr, &alnPool,
+				[&clusters, &refSeqs, &local](uint32_t pairPos, aligner & threadAligner) {
+					threadAligner.alignCache(refSeqs[pairPos % refSeqs.size()],
+							clusters[pairPos / refSeqs.size()], local);
+				},
+				[&alignerObj, &cacheMut, &added](aligner & threadAligner) {
+					std::lock_guard<std::mutex> lock(cacheMut);
+					added += addNewAlignments(threadAligner, alignerObj);
+				});
+		alignerObj.numberOfAlingmentsDone_ += added;
+		return added;
+	}
+
+	/**@brief Add the alignments in threadAligner's cache that alignerObj's cache lacks, used to hand a pooled aligner's alignments back to the aligner it was copied from
+	 *
+	 * @return the number of alignments added
+	 */
+	static uint64_t addNewAlignments(const aligner & threadAligner, aligner & alignerObj);
+
+private:
+	/**@brief Pairs of cluster positions (clus << 32 | read) that failed under failedPairsErrors_ and the iteration they failed in
+	 *
+	 * Only the most recent allowed errors are kept, repeated iterations in the parameter files and --converge reruns are consecutive
+	 * so this covers them without keeping a set of pairs for every error profile
+	 */
+	std::unordered_map<uint64_t, uint32_t> failedPairs_;
+	std::string failedPairsErrors_;
+	std::vector<uint32_t> changedIteration_; /**< by cluster position, the last iteration the cluster received reads in */
+	uint32_t iterationNumber_{0};
+
+	/**@brief Collapse each bin with binIteratorMap, at the same time on separate aligners, and put the bins' clusters back in clusters
+	 *
+	 */
+	void collapseBins(std::vector<cluster> & clusters,
+			const std::vector<std::vector<uint32_t>> & binPositions,
+			const CollapseIterations & binIteratorMap,
+			concurrent::AlignerPool * alnPool);
+
+	static void checkAlnPool(const concurrent::AlignerPool * alnPool,
+			const std::string & funcName);
+
+	/**@brief Run func(pos, aligner) for every pos in [0, num) spread over numThreads_ threads
+	 *
+	 * @param finishFunc if set, called by each thread with its aligner once the thread has no positions left
+	 * @return the number of alignments the aligners computed while running func
+	 */
+	uint64_t runOverPositions(uint32_t num, concurrent::AlignerPool * alnPool,
+			const std::function<void(uint32_t, aligner &)> & func,
+			const std::function<void(aligner &)> & finishFunc = nullptr) const;
+
+	/**@brief Run func(pos, aligner) for every pos in [0, num) on singleAligner if set, otherwise spread over numThreads threads each with an aligner from alnPool
+	 *
+	 */
+	static uint64_t runOverPositions(uint32_t num, uint32_t numThreads,
+			aligner * singleAligner, concurrent::AlignerPool * alnPool,
+			const std::function<void(uint32_t, aligner &)> & func,
+			const std::function<void(aligner &)> & finishFunc);
+};
+
+}  // namespace bibseq
+
+
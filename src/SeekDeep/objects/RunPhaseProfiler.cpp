@@ -0,0 +1,306 @@
+/*
+ * RunPhaseProfiler.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "RunPhaseProfiler.hpp"
+#include <sys/resource.h>
+
+namespace bibseq {
+
+RunPhaseProfiler::Usage RunPhaseProfiler::Usage::current() {
+	Usage ret;
+	ret.wall_ = std::chrono::steady_clock::now();
+	struct rusage usage;
+	if (0 == getrusage(RUSAGE_SELF, &usage)) {
+		ret.cpuSeconds_ = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0
+				+ usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+		//kilobytes on linux, bytes on mac
+#if defined(__APPLE__)
+		ret.peakRssKb_ = usage.ru_maxrss / 1024;
+#else
+		ret.peakRssKb_ = usage.ru_maxrss;
+#endif
+	}
+	return ret;
+}
+
+Json::Value RunPhaseProfiler::Phase::toJson() const {
+	Json::Value ret;
+	ret["name"] = bib::json::toJson(name_);
+	ret["wallSeconds"] = bib::json::toJson(wallSeconds_);
+	ret["cpuSeconds"] = bib::json::toJson(cpuSeconds_);
+	ret["peakRssKb"] = bib::json::toJson(peakRssKb_);
+	ret["peakRssIncreaseKb"] = bib::json::toJson(peakRssIncreaseKb_);
+	ret["alignmentsPerformed"] = bib::json::toJson(alignments_.performed_);
+	ret["alignmentCacheLookups"] = bib::json::toJson(alignments_.lookups_);
+	ret["alignmentCacheHits"] = bib::json::toJson(alignments_.lookups_ - alignments_.lookupsAligned_);
+	ret["countIn"] = bib::json::toJson(countIn_);
+	ret["countOut"] = bib::json::toJson(countOut_);
+	return ret;
+}
+
+RunPhaseProfiler::RunPhaseProfiler(const std::string & programName) :
+		programName_(programName), start_(Usage::current()), runStart_(start_) {
+}
+
+void RunPhaseProfiler::setAlignmentCounter(
+		const std::function<AlignmentCounts()> & counter) {
+	alignmentCounter_ = counter;
+	//only count alignments from here on in the current phase
+	startAlignments_ = currentAlignments();
+}
+
+RunPhaseProfiler::AlignmentCounts RunPhaseProfiler::currentAlignments() const {
+	if (alignmentCounter_) {
+		return alignmentCounter_();
+	}
+	return AlignmentCounts();
+}
+
+void RunPhaseProfiler::startPhase(const std::string & name, uint64_t countIn) {
+	endPhase(countIn);
+	Phase phase;
+	phase.name_ = name;
+	phase.countIn_ = countIn;
+	phases_.emplace_back(phase);
+	inPhase_ = true;
+	start_ = Usage::current();
+	startAlignments_ = currentAlignments();
+}
+
+void RunPhaseProfiler::endPhase(uint64_t countOut) {
+	if (!inPhase_) {
+		return;
+	}
+	auto end = Usage::current();
+	auto endAlignments = currentAlignments();
+	auto & phase = phases_.back();
+	phase.wallSeconds_ = std::chrono::duration<double>(end.wall_ - start_.wall_).count();
+	phase.cpuSeconds_ = end.cpuSeconds_ - start_.cpuSeconds_;
+	phase.peakRssKb_ = end.peakRssKb_;
+	phase.peakRssIncreaseKb_ = end.peakRssKb_ - start_.peakRssKb_;
+	phase.alignments_.performed_ = endAlignments.performed_ - startAlignments_.performed_;
+	phase.alignments_.lookups_ = endAlignments.lookups_ - startAlignments_.lookups_;
+	phase.alignments_.lookupsAligned_ = endAlignments.lookupsAligned_ - startAlignments_.lookupsAligned_;
+	phase.countOut_ = countOut;
+	inPhase_ = false;
+}
+
+void RunPhaseProfiler::addCountIn(uint64_t count) {
+	if (inPhase_) {
+		phases_.back().countIn_ += count;
+	}
+}
+
+const std::vector<RunPhaseProfiler::Phase> & RunPhaseProfiler::phases() const {
+	return phases_;
+}
+
+Json::Value RunPhaseProfiler::toJson() const {
+	Json::Value ret;
+	auto now = Usage::current();
+	ret["program"] = bib::json::toJson(programName_);
+	ret["meta"] = meta_;
+	ret["wallSeconds"] = bib::json::toJson(
+			std::chrono::duration<double>(now.wall_ - runStart_.wall_).count());
+	ret["cpuSeconds"] = bib::json::toJson(now.cpuSeconds_ - runStart_.cpuSeconds_);
+	ret["peakRssKb"] = bib::json::toJson(now.peakRssKb_);
+	auto & phases = ret["phases"];
+	phases = Json::Value(Json::arrayValue);
+	for (const auto & phase : phases_) {
+		phases.append(phase.toJson());
+	}
+	return ret;
+}
+
+void RunPhaseProfiler::finish(const bfs::path & fnp, uint64_t countOut) {
+	endPhase(countOut);
+	OutOptions profileOpts(fnp);
+	profileOpts.overWriteFile_ = true;
+	std::ofstream profileFile;
+	openTextFile(profileFile, profileOpts);
+	profileFile << toJson() << std::endl;
+}
+
+table RunPhaseProfiler::genPhasesTable(const std::vector<bfs::path> & profileFnps,
+		const bfs::path & topDir) {
+	table ret(VecStr { "runDir", "program", "phaseNumber", "phase",
+			"wallSeconds", "cpuSeconds", "fracOfRunWall", "peakRssKb",
+			"peakRssIncreaseKb", "alignmentsPerformed", "alignmentCacheLookups",
+			"alignmentCacheHits", "countIn", "countOut" });
+	for (const auto & fnp : profileFnps) {
+		auto profile = bib::json::parseFile(fnp.string());
+		if (!profile.isMember("phases") || !profile.isMember("program")) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error " << fnp
+					<< " is missing program or phases, not a run profile" << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		auto runDir = bfs::relative(fnp.parent_path(), topDir).string();
+		auto runWall = profile["wallSeconds"].asDouble();
+		uint32_t phaseNumber = 0;
+		for (const auto & phase : profile["phases"]) {
+			ret.addRow(runDir, profile["program"].asString(), phaseNumber,
+					phase["name"].asString(), phase["wallSeconds"].asDouble(),
+					phase["cpuSeconds"].asDouble(),
+					runWall > 0 ? phase["wallSeconds"].asDouble() / runWall : 0,
+					phase["peakRssKb"].asUInt64(), phase["peakRssIncreaseKb"].asUInt64(),
+					phase["alignmentsPerformed"].asUInt64(),
+					phase["alignmentCacheLookups"].asUInt64(),
+					phase["alignmentCacheHits"].asUInt64(),
+					phase["countIn"].asUInt64(), phase["countOut"].asUInt64());
+			++phaseNumber;
+		}
+	}
+	return ret;
+}
+
+namespace {
+uint32_t getColumnPosition(const table & tab, const std::string & column) {
+	auto colPos = std::find(tab.columnNames_.begin(), tab.columnNames_.end(), column);
+	if (tab.columnNames_.end() == colPos) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error table doesn't have column " << column
+				<< ", should be a table from RunPhaseProfiler::genPhasesTable" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	return std::distance(tab.columnNames_.begin(), colPos);
+}
+}  // namespace
+
+table RunPhaseProfiler::genByPhaseTable(const table & phasesTab) {
+	auto runCol = getColumnPosition(phasesTab, "runDir");
+	auto programCol = getColumnPosition(phasesTab, "program");
+	auto phaseCol = getColumnPosition(phasesTab, "phase");
+	auto wallCol = getColumnPosition(phasesTab, "wallSeconds");
+	auto cpuCol = getColumnPosition(phasesTab, "cpuSeconds");
+	auto rssCol = getColumnPosition(phasesTab, "peakRssIncreaseKb");
+	auto alnsCol = getColumnPosition(phasesTab, "alignmentsPerformed");
+	auto hitsCol = getColumnPosition(phasesTab, "alignmentCacheHits");
+	struct PhaseTotals {
+		uint32_t runs_{0};
+		double wall_{0};
+		double maxWall_{0};
+		std::string maxWallRun_;
+		double cpu_{0};
+		uint64_t maxRssIncrease_{0};
+		uint64_t alignments_{0};
+		uint64_t cacheHits_{0};
+	};
+	std::map<std::pair<std::string, std::string>, PhaseTotals> totals;
+	double allWall = 0;
+	for (const auto & row : phasesTab.content_) {
+		auto & phaseTotals = totals[std::make_pair(row[programCol], row[phaseCol])];
+		auto wall = std::stod(row[wallCol]);
+		++phaseTotals.runs_;
+		phaseTotals.wall_ += wall;
+		allWall += wall;
+		if (wall >= phaseTotals.maxWall_) {
+			phaseTotals.maxWall_ = wall;
+			phaseTotals.maxWallRun_ = row[runCol];
+		}
+		phaseTotals.cpu_ += std::stod(row[cpuCol]);
+		phaseTotals.maxRssIncrease_ = std::max<uint64_t>(phaseTotals.maxRssIncrease_,
+				std::stoull(row[rssCol]));
+		phaseTotals.alignments_ += std::stoull(row[alnsCol]);
+		phaseTotals.cacheHits_ += std::stoull(row[hitsCol]);
+	}
+	std::vector<std::pair<std::pair<std::string, std::string>, PhaseTotals>> sortedTotals(
+			totals.begin(), totals.end());
+	std::stable_sort(sortedTotals.begin(), sortedTotals.end(),
+			[](const std::pair<std::pair<std::string, std::string>, PhaseTotals> & total1,
+					const std::pair<std::pair<std::string, std::string>, PhaseTotals> & total2) {
+				return total1.second.wall_ > total2.second.wall_;
+			});
+	table ret(VecStr { "program", "phase", "runs", "totalWallSeconds",
+			"fracOfAllWall", "meanWallSeconds", "maxWallSeconds", "maxWallRunDir",
+			"totalCpuSeconds", "maxPeakRssIncreaseKb", "alignmentsPerformed",
+			"alignmentCacheHits" });
+	for (const auto & total : sortedTotals) {
+		const auto & phaseTotals = total.second;
+		ret.addRow(total.first.first, total.first.second, phaseTotals.runs_,
+				phaseTotals.wall_, allWall > 0 ? phaseTotals.wall_ / allWall : 0,
+				phaseTotals.wall_ / phaseTotals.runs_, phaseTotals.maxWall_,
+				phaseTotals.maxWallRun_, phaseTotals.cpu_,
+				phaseTotals.maxRssIncrease_, phaseTotals.alignments_,
+				phaseTotals.cacheHits_);
+	}
+	return ret;
+}
+
+table RunPhaseProfiler::genByRunTable(const table & phasesTab) {
+	auto runCol = getColumnPosition(phasesTab, "runDir");
+	auto programCol = getColumnPosition(phasesTab, "program");
+	auto phaseCol = getColumnPosition(phasesTab, "phase");
+	auto wallCol = getColumnPosition(phasesTab, "wallSeconds");
+	auto cpuCol = getColumnPosition(phasesTab, "cpuSeconds");
+	auto rssCol = getColumnPosition(phasesTab, "peakRssKb");
+	auto alnsCol = getColumnPosition(phasesTab, "alignmentsPerformed");
+	struct RunTotals {
+		std::string program_;
+		double wall_{0};
+		double cpu_{0};
+		uint64_t peakRss_{0};
+		uint64_t alignments_{0};
+		std::string slowestPhase_;
+		double slowestPhaseWall_{0};
+	};
+	//keep the runs in the order they were first seen so ties stay in the phases table's order
+	std::vector<std::string> runOrder;
+	std::unordered_map<std::string, RunTotals> totals;
+	for (const auto & row : phasesTab.content_) {
+		if (totals.end() == totals.find(row[runCol])) {
+			runOrder.emplace_back(row[runCol]);
+		}
+		auto & runTotals = totals[row[runCol]];
+		auto wall = std::stod(row[wallCol]);
+		runTotals.program_ = row[programCol];
+		runTotals.wall_ += wall;
+		runTotals.cpu_ += std::stod(row[cpuCol]);
+		runTotals.peakRss_ = std::max<uint64_t>(runTotals.peakRss_, std::stoull(row[rssCol]));
+		runTotals.alignments_ += std::stoull(row[alnsCol]);
+		if (wall >= runTotals.slowestPhaseWall_) {
+			runTotals.slowestPhaseWall_ = wall;
+			runTotals.slowestPhase_ = row[phaseCol];
+		}
+	}
+	std::stable_sort(runOrder.begin(), runOrder.end(),
+			[&totals](const std::string & run1, const std::string & run2) {
+				return totals.at(run1).wall_ > totals.at(run2).wall_;
+			});
+	table ret(VecStr { "runDir", "program", "wallSeconds", "cpuSeconds",
+			"peakRssKb", "alignmentsPerformed", "slowestPhase",
+			"slowestPhaseWallSeconds" });
+	for (const auto & run : runOrder) {
+		const auto & runTotals = totals.at(run);
+		ret.addRow(run, runTotals.program_, runTotals.wall_, runTotals.cpu_,
+				runTotals.peakRss_, runTotals.alignments_, runTotals.slowestPhase_,
+				runTotals.slowestPhaseWall_);
+	}
+	return ret;
+}
+
+}  // namespace bibseq
@@ -0,0 +1,151 @@
+#pragma once
+/*
+ * RunPhaseProfiler.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+
+
+namespace bibseq {
+
+/**@brief Record per phase timing, memory and alignment counts of a run and write them out as json
+ *
+ * A phase lasts from its start until the next phase starts or the profile is finished,
+ * cpu time and peak rss are for the whole process so they include all threads working during the phase
+ *
+ */
+class RunPhaseProfiler {
+public:
+
+	/**@brief Running totals of alignment work, phases record the difference between their start and end
+	 *
+	 */
+	struct AlignmentCounts {
+		uint64_t performed_{0}; /**< alignments actually computed */
+		uint64_t lookups_{0}; /**< comparisons that went through the alignment cache and were counted */
+		uint64_t lookupsAligned_{0}; /**< of lookups_, the ones that weren't in the cache and had to be aligned, already included in performed_ */
+	};
+
+	struct Phase {
+		std::string name_;
+		double wallSeconds_{0};
+		double cpuSeconds_{0};
+		uint64_t peakRssKb_{0}; /**< process peak resident memory at the end of the phase */
+		uint64_t peakRssIncreaseKb_{0}; /**< how much the phase raised the process peak resident memory */
+		AlignmentCounts alignments_;
+		uint64_t countIn_{0};
+		uint64_t countOut_{0};
+
+		Json::Value toJson() const;
+	};
+
+	/**@brief Resource usage of the whole process at a point in time
+	 *
+	 */
+	struct Usage {
+		std::chrono::steady_clock::time_point wall_;
+		double cpuSeconds_{0}; /**< user plus system time of all threads */
+		uint64_t peakRssKb_{0};
+
+		static Usage current();
+	};
+
+	RunPhaseProfiler(const std::string & programName);
+
+	const std::string programName_;
+	Json::Value meta_; /**< extra information about the run written with the profile, e.g. input file and threads */
+
+	/**@brief Set how to get the running alignment totals, called at the start and end of every phase
+	 *
+	 * @param counter returns the current totals, the totals can only grow
+	 */
+	void setAlignmentCounter(const std::function<AlignmentCounts()> & counter);
+
+	/**@brief Start a phase, ending the current phase if there is one with countIn as its count out
+	 *
+	 * @param name the name of the phase
+	 * @param countIn the number of reads or clusters the phase starts with
+	 */
+	void startPhase(const std::string & name, uint64_t countIn);
+
+	/**@brief End the current phase, does nothing if there isn't one
+	 *
+	 * @param countOut the number of reads or clusters the phase ended with
+	 */
+	void endPhase(uint64_t countOut);
+
+	/**@brief Add to the current phase's counts in, for when the count is only known after the phase starts
+	 *
+	 */
+	void addCountIn(uint64_t count);
+
+	const std::vector<Phase> & phases() const;
+
+	Json::Value toJson() const;
+
+	/**@brief End the current phase and write the profile
+	 *
+	 * @param fnp where to write the json
+	 * @param countOut the count out for the current phase
+	 */
+	void finish(const bfs::path & fnp, uint64_t countOut);
+
+	/**@brief Summarize the profiles written by finish() under a directory
+	 *
+	 * @param profileFnps the profiles to summarize
+	 * @param topDir run directories are reported relative to this
+	 * @return a table with a row for each phase of each run
+	 */
+	static table genPhasesTable(const std::vector<bfs::path> & profileFnps,
+			const bfs::path & topDir);
+
+	/**@brief Total a phases table by program and phase
+	 *
+	 * @param phasesTab the table from genPhasesTable
+	 * @return a table with a row per program and phase, sorted by total wall time
+	 */
+	static table genByPhaseTable(const table & phasesTab);
+
+	/**@brief Total a phases table by run
+	 *
+	 * @param phasesTab the table from genPhasesTable
+	 * @return a table with a row per run with its slowest phase, sorted by total wall time
+	 */
+	static table genByRunTable(const table & phasesTab);
+
+private:
+	std::vector<Phase> phases_;
+	bool inPhase_{false};
+	Usage start_;
+	Usage runStart_;
+	AlignmentCounts startAlignments_;
+	std::function<AlignmentCounts()> alignmentCounter_;
+
+	AlignmentCounts currentAlignments() const;
+};
+
+}  // namespace bibseq
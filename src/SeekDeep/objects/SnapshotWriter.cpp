@@ -0,0 +1,202 @@
+/*
+ * SnapshotWriter.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "SnapshotWriter.hpp"
+
+namespace bibseq {
+
+SnapshotWriter::SnapshotWriter(const bfs::path & outDir, uint32_t maxQueued) :
+		outDir_(outDir), maxQueued_(std::max<uint32_t>(maxQueued, 1)),
+		writer_(&SnapshotWriter::runWriter, this) {
+}
+
+SnapshotWriter::~SnapshotWriter() {
+	try {
+		finish();
+	} catch (const std::exception & e) {
+		std::cerr << e.what() << std::endl;
+	}
+}
+
+void SnapshotWriter::capture(const std::string & dirName,
+		const std::string & label, const std::vector<cluster> & clusters,
+		const std::vector<uint32_t> & order) {
+	Snapshot snap;
+	snap.dirName_ = dirName;
+	snap.label_ = label;
+	snap.clusters_.reserve(order.size());
+	for (const auto clusPos : order) {
+		const auto & clus = clusters[clusPos];
+		ClusterState state;
+		state.name_ = clus.seqBase_.name_;
+		state.cnt_ = clus.seqBase_.cnt_;
+		auto seqId = seqIds_.emplace(clus.seqBase_.seq_, seqIds_.size());
+		if (seqId.second) {
+			snap.newSeqs_.emplace_back(clus.seqBase_.seq_);
+		}
+		state.seqId_ = seqId.first->second;
+		state.memberIds_.reserve(clus.reads_.size());
+		for (const auto & read : clus.reads_) {
+			auto memberId = memberIds_.emplace(read.get(), memberIds_.size());
+			if (memberId.second) {
+				heldMembers_.emplace_back(read);
+				Member member;
+				member.name_ = read->seqBase_.name_;
+				member.cnt_ = read->seqBase_.cnt_;
+				snap.newMembers_.emplace_back(member);
+			}
+			state.memberIds_.emplace_back(memberId.first->second);
+		}
+		snap.clusters_.emplace_back(std::move(state));
+	}
+	{
+		std::lock_guard<std::mutex> lock(mut_);
+		if (done_) {
+			std::stringstream ss;
+			ss << __PRETTY_FUNCTION__ << ", error capturing " << dirName << "/"
+					<< label << " after finish() was called" << "\n";
+			throw std::runtime_error { ss.str() };
+		}
+		if (queue_.size() >= maxQueued_) {
+			//rather than wait on the writer the newest snapshot replaces the last waiting one, keeping its new sequences and reads
+			auto & last = queue_.back();
+			last.coalescedLabels_.emplace_back(last.dirName_ + "/" + last.label_);
+			last.dirName_ = snap.dirName_;
+			last.label_ = snap.label_;
+			last.clusters_ = std::move(snap.clusters_);
+			addOtherVec(last.newSeqs_, snap.newSeqs_);
+			addOtherVec(last.newMembers_, snap.newMembers_);
+			++coalesced_;
+		} else {
+			queue_.emplace_back(std::move(snap));
+		}
+	}
+	cond_.notify_one();
+}
+
+void SnapshotWriter::capture(const std::string & dirName,
+		const std::string & label, const std::vector<cluster> & clusters) {
+	std::vector<uint32_t> order;
+	for (const auto clusPos : iter::range<uint32_t>(clusters.size())) {
+		if (!clusters[clusPos].remove) {
+			order.emplace_back(clusPos);
+		}
+	}
+	capture(dirName, label, clusters, order);
+}
+
+void SnapshotWriter::runWriter() {
+	while (true) {
+		Snapshot snap;
+		{
+			std::unique_lock<std::mutex> lock(mut_);
+			cond_.wait(lock, [this]() {return done_ || !queue_.empty();});
+			if (queue_.empty()) {
+				return;
+			}
+			snap = std::move(queue_.front());
+			queue_.pop_front();
+		}
+		try {
+			writeSnapshot(snap);
+			++written_;
+		} catch (...) {
+			//keep draining the queue so captures never wait, the error is thrown from finish()
+			std::lock_guard<std::mutex> lock(mut_);
+			if (!writerError_) {
+				writerError_ = std::current_exception();
+			}
+		}
+	}
+}
+
+void SnapshotWriter::writeSnapshot(const Snapshot & snap) {
+	addOtherVec(seqs_, snap.newSeqs_);
+	addOtherVec(members_, snap.newMembers_);
+	auto snapDir = bib::files::make_path(outDir_, snap.dirName_, snap.label_);
+	bfs::create_directories(snapDir);
+	auto openOut = [&snapDir](std::ofstream & out, const std::string & fileName) {
+		OutOptions outOpts(bib::files::make_path(snapDir, fileName));
+		outOpts.overWriteFile_ = true;
+		openTextFile(out, outOpts);
+	};
+	double total = 0;
+	for (const auto & clus : snap.clusters_) {
+		total += clus.cnt_;
+	}
+	std::ofstream seqsFile;
+	openOut(seqsFile, "clusters.fasta");
+	std::ofstream clustersFile;
+	openOut(clustersFile, "clusters.tab.txt");
+	clustersFile << "clusterName\treadCnt\tfraction\tmembers\n";
+	std::ofstream membersFile;
+	openOut(membersFile, "members.tab.txt");
+	membersFile << "clusterName\tmemberName\tmemberReadCnt\n";
+	for (const auto & clus : snap.clusters_) {
+		seqsFile << ">" << clus.name_ << "\n" << seqs_[clus.seqId_] << "\n";
+		clustersFile << clus.name_ << "\t" << clus.cnt_ << "\t"
+				<< (total > 0 ? clus.cnt_ / total : 0) << "\t"
+				<< clus.memberIds_.size() << "\n";
+		for (const auto memberId : clus.memberIds_) {
+			membersFile << clus.name_ << "\t" << members_[memberId].name_ << "\t"
+					<< members_[memberId].cnt_ << "\n";
+		}
+	}
+	if (!snap.coalescedLabels_.empty()) {
+		std::ofstream coalescedFile;
+		openOut(coalescedFile, "coalesced.txt");
+		for (const auto & coalescedLabel : snap.coalescedLabels_) {
+			coalescedFile << coalescedLabel << "\n";
+		}
+	}
+}
+
+void SnapshotWriter::finish() {
+	{
+		std::lock_guard<std::mutex> lock(mut_);
+		done_ = true;
+	}
+	cond_.notify_one();
+	if (writer_.joinable()) {
+		writer_.join();
+	}
+	if (writerError_) {
+		auto error = writerError_;
+		writerError_ = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+uint32_t SnapshotWriter::numberWritten() const {
+	return written_;
+}
+
+uint32_t SnapshotWriter::numberCoalesced() const {
+	return coalesced_;
+}
+
+}  // namespace bibseq
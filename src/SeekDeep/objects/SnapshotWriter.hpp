@@ -0,0 +1,123 @@
+#pragma once
+/*
+ * SnapshotWriter.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+#include <condition_variable>
+
+
+namespace bibseq {
+
+/**@brief Write clustering snapshots on a background thread so clustering doesn't wait on formatting and disk writes
+ *
+ * A capture only copies each cluster's name, count, a sequence id and the ids of the input reads collapsed into it,
+ * sequences and input reads are sent to the writer once, the first time they are seen.
+ * At most maxQueued snapshots wait to be written, when clustering gets further ahead than that the newest snapshot
+ * replaces the last waiting one and the replaced iteration is listed in the written snapshot's coalesced.txt
+ *
+ * Each snapshot is written to outDir/dirName/label/ as clusters.fasta, clusters.tab.txt and members.tab.txt
+ *
+ */
+class SnapshotWriter {
+public:
+
+	SnapshotWriter(const bfs::path & outDir, uint32_t maxQueued);
+	~SnapshotWriter();
+
+	const bfs::path outDir_;
+	const uint32_t maxQueued_;
+
+	/**@brief Capture the clusters at the given positions, should always be called from the same thread
+	 *
+	 * @param dirName the snapshot directory, e.g. firstSnaps
+	 * @param label the name of the snapshot within dirName, e.g. the iteration number
+	 * @param clusters the clusters
+	 * @param order the positions of the clusters to capture, in the order to write them
+	 */
+	void capture(const std::string & dirName, const std::string & label,
+			const std::vector<cluster> & clusters, const std::vector<uint32_t> & order);
+
+	/**@brief Capture all the clusters not marked remove
+	 *
+	 */
+	void capture(const std::string & dirName, const std::string & label,
+			const std::vector<cluster> & clusters);
+
+	/**@brief Wait for the waiting snapshots to be written and stop the writer, throws if the writer failed
+	 *
+	 */
+	void finish();
+
+	uint32_t numberWritten() const;
+	uint32_t numberCoalesced() const;
+
+private:
+	struct ClusterState {
+		std::string name_;
+		double cnt_{0};
+		uint32_t seqId_{0};
+		std::vector<uint32_t> memberIds_;
+	};
+
+	struct Member {
+		std::string name_;
+		double cnt_{0};
+	};
+
+	struct Snapshot {
+		std::string dirName_;
+		std::string label_;
+		std::vector<ClusterState> clusters_;
+		std::vector<std::string> newSeqs_; /**< sequences first seen in this capture, their ids follow on from the previous captures' */
+		std::vector<Member> newMembers_; /**< input reads first seen in this capture, ids follow on the same way */
+		VecStr coalescedLabels_; /**< labels of the waiting snapshots this one replaced */
+	};
+
+	//capture side, only used by the capturing thread
+	std::unordered_map<std::string, uint32_t> seqIds_;
+	std::unordered_map<const readObject *, uint32_t> memberIds_;
+	std::vector<std::shared_ptr<readObject>> heldMembers_; /**< keeps the reads alive so their addresses aren't reused by other reads */
+
+	//writer side, only used by the writer thread
+	VecStr seqs_;
+	std::vector<Member> members_;
+
+	std::deque<Snapshot> queue_;
+	std::mutex mut_;
+	std::condition_variable cond_;
+	bool done_{false};
+	std::exception_ptr writerError_;
+	std::atomic<uint32_t> written_{0};
+	std::atomic<uint32_t> coalesced_{0};
+	std::thread writer_;
+
+	void runWriter();
+	void writeSnapshot(const Snapshot & snap);
+};
+
+}  // namespace bibseq
@@ -0,0 +1,259 @@
+/*
+ * StreamingIdenticalCollapser.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "StreamingIdenticalCollapser.hpp"
+
+
+namespace bibseq {
+
+StreamingIdenticalCollapser::Unique::Unique(const seqInfo & firstRead) :
+		seq_(firstRead) {
+}
+
+StreamingIdenticalCollapser::StreamingIdenticalCollapser(
+		const std::string & qualRep) :
+		qualRep_(qualRep) {
+	if ("median" != qualRep_ && "average" != qualRep_
+			&& "bestQual" != qualRep_ && "worst" != qualRep_) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error qualRep should be median, average, bestQual, or worst, not "
+				<< qualRep_ << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+}
+
+void StreamingIdenticalCollapser::addQualCount(
+		std::vector<std::pair<uint32_t, double>> & counts, uint32_t qual,
+		double count) {
+	//few distinct qualities per position so a sorted vector is smaller and faster than a map
+	auto pos = std::lower_bound(counts.begin(), counts.end(), qual,
+			[](const std::pair<uint32_t, double> & qualCount, uint32_t q) {
+				return qualCount.first < q;
+			});
+	if (counts.end() != pos && qual == pos->first) {
+		pos->second += count;
+	} else {
+		counts.insert(pos, std::make_pair(qual, count));
+	}
+}
+
+uint32_t StreamingIdenticalCollapser::getMedianQual(
+		const std::vector<std::pair<uint32_t, double>> & counts) {
+	uint64_t total = 0;
+	for (const auto & qualCount : counts) {
+		total += std::llround(qualCount.second);
+	}
+	if (0 == total) {
+		return 0;
+	}
+	//same as the median of all the qualities, the mean of the two middle values when even
+	uint64_t lowRank = (total - 1) / 2;
+	uint64_t highRank = total / 2;
+	uint32_t lowQual = 0;
+	uint32_t highQual = 0;
+	uint64_t cumulative = 0;
+	bool lowFound = false;
+	for (const auto & qualCount : counts) {
+		cumulative += std::llround(qualCount.second);
+		if (!lowFound && cumulative > lowRank) {
+			lowQual = qualCount.first;
+			lowFound = true;
+		}
+		if (cumulative > highRank) {
+			highQual = qualCount.first;
+			break;
+		}
+	}
+	return static_cast<uint32_t>((lowQual + highQual) / 2.0);
+}
+
+void StreamingIdenticalCollapser::addRead(const seqInfo & read) {
+	readCount_ += read.cnt_;
+	auto search = seqToUniquePos_.find(read.seq_);
+	if (seqToUniquePos_.end() == search) {
+		seqToUniquePos_[read.seq_] = uniques_.size();
+		uniques_.emplace_back(read);
+		setUpTransformCheck(uniques_.back());
+		return;
+	}
+	auto & unique = uniques_[search->second];
+	checkTransforms(unique, read);
+	if ("median" == qualRep_) {
+		if (unique.qualCounts_.empty()) {
+			unique.qualCounts_.resize(unique.seq_.qual_.size());
+			for (const auto pos : iter::range(unique.seq_.qual_.size())) {
+				addQualCount(unique.qualCounts_[pos], unique.seq_.qual_[pos], unique.seq_.cnt_);
+			}
+		}
+		for (const auto pos : iter::range(read.qual_.size())) {
+			addQualCount(unique.qualCounts_[pos], read.qual_[pos], read.cnt_);
+		}
+	} else if ("average" == qualRep_) {
+		if (unique.qualSums_.empty()) {
+			for (const auto & qual : unique.seq_.qual_) {
+				unique.qualSums_.emplace_back(qual * unique.seq_.cnt_);
+			}
+		}
+		for (const auto pos : iter::range(read.qual_.size())) {
+			unique.qualSums_[pos] += read.qual_[pos] * read.cnt_;
+		}
+	} else if ("bestQual" == qualRep_) {
+		for (const auto pos : iter::range(read.qual_.size())) {
+			unique.seq_.qual_[pos] = std::max(unique.seq_.qual_[pos], read.qual_[pos]);
+		}
+	} else {
+		for (const auto pos : iter::range(read.qual_.size())) {
+			unique.seq_.qual_[pos] = std::min(unique.seq_.qual_[pos], read.qual_[pos]);
+		}
+	}
+	unique.seq_.cnt_ += read.cnt_;
+}
+
+void StreamingIdenticalCollapser::setTransformChecks(bool removeLowQualityBases,
+		uint32_t lowQualityCutOff, bool adjustHomopolymerRuns) {
+	if (!uniques_.empty()) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error transform checks have to be set before adding reads" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	checkRemoveLowQualityBases_ = removeLowQualityBases;
+	lowQualityCutOff_ = lowQualityCutOff;
+	checkAdjustHomopolymerRuns_ = adjustHomopolymerRuns;
+}
+
+uint32_t StreamingIdenticalCollapser::numberOfNonCommutingUniques() const {
+	return nonCommutingUniques_;
+}
+
+bool StreamingIdenticalCollapser::isLowQuality(uint32_t qual) const {
+	//the same comparison seqInfo::removeLowQualityBases uses, bases below the cut off are removed and ones at it are kept
+	return checkRemoveLowQualityBases_ && qual < lowQualityCutOff_;
+}
+
+void StreamingIdenticalCollapser::setUpTransformCheck(Unique & unique) const {
+	if (!checkRemoveLowQualityBases_ && !checkAdjustHomopolymerRuns_) {
+		return;
+	}
+	unique.firstQual_ = unique.seq_.qual_;
+	if (!checkAdjustHomopolymerRuns_) {
+		return;
+	}
+	//runs are found on the sequence left after trimming as removing a base can join two runs
+	std::vector<uint32_t> kept;
+	for (const auto pos : iter::range<uint32_t>(unique.seq_.seq_.size())) {
+		if (!isLowQuality(unique.firstQual_[pos])) {
+			kept.emplace_back(pos);
+		}
+	}
+	unique.runPositions_.clear();
+	for (const auto keptPos : iter::range<uint32_t>(kept.size())) {
+		char base = unique.seq_.seq_[kept[keptPos]];
+		if ((keptPos > 0 && unique.seq_.seq_[kept[keptPos - 1]] == base)
+				|| (keptPos + 1 < kept.size() && unique.seq_.seq_[kept[keptPos + 1]] == base)) {
+			unique.runPositions_.emplace_back(kept[keptPos]);
+		}
+	}
+}
+
+void StreamingIdenticalCollapser::checkTransforms(Unique & unique,
+		const seqInfo & read) {
+	if (!unique.commutes_ || unique.firstQual_.empty()) {
+		return;
+	}
+	bool commutes = true;
+	if (checkRemoveLowQualityBases_) {
+		for (const auto pos : iter::range(read.qual_.size())) {
+			if (isLowQuality(read.qual_[pos]) != isLowQuality(unique.firstQual_[pos])) {
+				commutes = false;
+				break;
+			}
+		}
+	}
+	if (commutes && checkAdjustHomopolymerRuns_) {
+		for (const auto & pos : unique.runPositions_) {
+			if (read.qual_[pos] != unique.firstQual_[pos]) {
+				commutes = false;
+				break;
+			}
+		}
+	}
+	if (!commutes) {
+		unique.commutes_ = false;
+		++nonCommutingUniques_;
+	}
+}
+
+std::string StreamingIdenticalCollapser::genUniqueName(
+		const Unique & unique) const {
+	//replace a previous _t[count] with the collapsed count
+	auto name = unique.seq_.name_;
+	auto tPos = name.rfind("_t");
+	if (std::string::npos != tPos && tPos + 2 < name.size()
+			&& std::all_of(name.begin() + tPos + 2, name.end(), ::isdigit)) {
+		name = name.substr(0, tPos);
+	}
+	return name + "_t" + estd::to_string(std::llround(unique.seq_.cnt_));
+}
+
+std::vector<seqInfo> StreamingIdenticalCollapser::getUniqueSeqs() const {
+	std::vector<seqInfo> ret;
+	ret.reserve(uniques_.size());
+	for (const auto & unique : uniques_) {
+		ret.emplace_back(unique.seq_);
+		auto & seq = ret.back();
+		if (!unique.qualCounts_.empty()) {
+			for (const auto pos : iter::range(seq.qual_.size())) {
+				seq.qual_[pos] = getMedianQual(unique.qualCounts_[pos]);
+			}
+		} else if (!unique.qualSums_.empty()) {
+			for (const auto pos : iter::range(seq.qual_.size())) {
+				seq.qual_[pos] = static_cast<uint32_t>(std::round(unique.qualSums_[pos] / unique.seq_.cnt_));
+			}
+		}
+		seq.name_ = genUniqueName(unique);
+	}
+	return ret;
+}
+
+std::string StreamingIdenticalCollapser::getUniqueName(
+		const std::string & seq) const {
+	auto search = seqToUniquePos_.find(seq);
+	if (seqToUniquePos_.end() == search) {
+		return "";
+	}
+	return genUniqueName(uniques_[search->second]);
+}
+
+uint32_t StreamingIdenticalCollapser::numberOfUniques() const {
+	return uniques_.size();
+}
+
+double StreamingIdenticalCollapser::numberOfReads() const {
+	return readCount_;
+}
+
+}  // namespace bibseq
@@ -0,0 +1,121 @@
+#pragma once
+/*
+ * StreamingIdenticalCollapser.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+
+
+namespace bibseq {
+
+/**@brief Collapse reads to unique sequences as they are read in so only the unique sequences are held in memory
+ *
+ * Qualities are combined per position as reads are added according to the quality representation (median, average, bestQual, worst),
+ * for median a small per position histogram of quality counts is kept rather than every quality
+ *
+ */
+class StreamingIdenticalCollapser {
+public:
+
+	StreamingIdenticalCollapser(const std::string & qualRep);
+
+	const std::string qualRep_;
+
+	/**@brief Add a read, if its sequence has been seen before it's counted towards that unique sequence
+	 *
+	 * @param read the read to add, its cnt_ is used as the number of reads it represents
+	 */
+	void addRead(const seqInfo & read);
+
+	/**@brief Get the unique sequences with the combined qualities, named as the first read seen with that sequence
+	 *
+	 * @return the unique sequences with cnt_ set to the number of reads collapsed into them
+	 */
+	std::vector<seqInfo> getUniqueSeqs() const;
+
+	/**@brief Get the name of the unique sequence a sequence was collapsed into
+	 *
+	 * @param seq the sequence
+	 * @return the name given to the unique sequence in getUniqueSeqs(), blank if the sequence was never added
+	 */
+	std::string getUniqueName(const std::string & seq) const;
+
+	uint32_t numberOfUniques() const;
+	double numberOfReads() const;
+
+	/**@brief Check as reads are added whether removing low quality bases and adjusting homopolymer run qualities could be done once per unique sequence
+	 * instead of on every read before collapsing, must be set before any reads are added
+	 *
+	 * The transforms give the same result either way for a unique sequence when all its reads have their low quality bases at the same positions
+	 * and the same qualities within the homopolymer runs left after trimming
+	 *
+	 * @param removeLowQualityBases whether low quality bases will be removed
+	 * @param lowQualityCutOff the quality below which bases are removed
+	 * @param adjustHomopolymerRuns whether homopolymer run qualities will be adjusted
+	 */
+	void setTransformChecks(bool removeLowQualityBases, uint32_t lowQualityCutOff,
+			bool adjustHomopolymerRuns);
+
+	/**@brief The number of unique sequences whose reads differ where the checked transforms depend on them, if not 0 the transforms have to be done per read
+	 *
+	 */
+	uint32_t numberOfNonCommutingUniques() const;
+
+private:
+	struct Unique {
+		Unique(const seqInfo & firstRead);
+		seqInfo seq_; /**< first read seen, qualities hold the running best/worst when representing by those */
+		std::vector<double> qualSums_; /**< running sums for average */
+		std::vector<std::vector<std::pair<uint32_t, double>>> qualCounts_; /**< per position (quality, count) sorted by quality for median, only filled in once a second read is added */
+		std::vector<uint32_t> firstQual_; /**< qualities of the first read, only kept when checking transforms */
+		std::vector<uint32_t> runPositions_; /**< positions in homopolymer runs after trimming, where reads have to have the same qualities */
+		bool commutes_{true};
+	};
+
+	bool checkRemoveLowQualityBases_{false};
+	uint32_t lowQualityCutOff_{0};
+	bool checkAdjustHomopolymerRuns_{false};
+	uint32_t nonCommutingUniques_{0};
+
+	bool isLowQuality(uint32_t qual) const;
+	void setUpTransformCheck(Unique & unique) const;
+	void checkTransforms(Unique & unique, const seqInfo & read);
+
+	std::unordered_map<std::string, uint32_t> seqToUniquePos_;
+	std::vector<Unique> uniques_;
+	double readCount_{0};
+
+	static void addQualCount(std::vector<std::pair<uint32_t, double>> & counts,
+			uint32_t qual, double count);
+	static uint32_t getMedianQual(
+			const std::vector<std::pair<uint32_t, double>> & counts);
+	std::string genUniqueName(const Unique & unique) const;
+};
+
+}  // namespace bibseq
+
+
@@ -50,6 +50,8 @@ public:
 		bool debug = false;
 
 		uint32_t numThreads = 1;
+		uint32_t qlusterNumThreads = 1;
+		bool sharedAlnCache = false;
 
 		std::string technology = "illumina";
 
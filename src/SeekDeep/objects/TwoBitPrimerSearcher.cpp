@@ -0,0 +1,288 @@
+/*
+ * TwoBitPrimerSearcher.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "TwoBitPrimerSearcher.hpp"
+
+
+namespace bibseq {
+
+TwoBitPrimerSearcher::Primer::Primer(const std::string & target, bool forward,
+		const std::string & seq) :
+		target_(target), forward_(forward), seq_(seq) {
+}
+
+TwoBitPrimerSearcher::Amplicon::Amplicon(const GenomicRegion & region,
+		const GenomicRegion & innerRegion) :
+		region_(region), innerRegion_(innerRegion) {
+}
+
+int8_t TwoBitPrimerSearcher::encodeBase(char base) {
+	switch (base) {
+	case 'A':
+	case 'a':
+		return 0;
+	case 'C':
+	case 'c':
+		return 1;
+	case 'G':
+	case 'g':
+		return 2;
+	case 'T':
+	case 't':
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+TwoBitPrimerSearcher::TwoBitPrimerSearcher(const std::vector<Primer> & primers,
+		uint32_t allowableMismatches) :
+		primers_(primers), allowableMismatches_(allowableMismatches) {
+	if (primers_.empty()) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error no primers given to search for" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	uint32_t minPatternLen = std::numeric_limits<uint32_t>::max();
+	for (const auto pos : iter::range(primers_.size())) {
+		const auto & primer = primers_[pos];
+		for (const auto & base : primer.seq_) {
+			if (encodeBase(base) < 0) {
+				std::stringstream ss;
+				ss << __PRETTY_FUNCTION__ << ", error primer " << primer.target_
+						<< " " << (primer.forward_ ? "forward" : "reverse") << " " << primer.seq_
+						<< " contains a non ACGT base, degenerate primers need to be expanded first" << "\n";
+				throw std::runtime_error { ss.str() };
+			}
+		}
+		patterns_.emplace_back(Pattern { static_cast<uint32_t>(pos), false, primer.seq_ });
+		patterns_.emplace_back(Pattern { static_cast<uint32_t>(pos), true,
+			seqUtil::reverseComplement(primer.seq_, "DNA") });
+		minPatternLen = std::min<uint32_t>(minPatternLen, primer.seq_.size());
+		maxPatternLen_ = std::max<uint32_t>(maxPatternLen_, primer.seq_.size());
+	}
+	//allowableMismatches_ + 1 non-overlapping seeds guarantees a hit with that many mismatches still contains one exact seed
+	kLen_ = std::min<uint32_t>(16, minPatternLen / (allowableMismatches_ + 1));
+	if (0 == kLen_) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error the shortest primer, length "
+				<< minPatternLen << ", is too short to search for with "
+				<< allowableMismatches_ << " mismatches" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	for (const auto patPos : iter::range(patterns_.size())) {
+		const auto & seq = patterns_[patPos].seq_;
+		for (uint32_t seedNum = 0; seedNum <= allowableMismatches_; ++seedNum) {
+			uint32_t offset = seedNum * kLen_;
+			uint32_t code = 0;
+			for (const auto basePos : iter::range<uint32_t>(offset, offset + kLen_)) {
+				code = (code << 2) | static_cast<uint32_t>(encodeBase(seq[basePos]));
+			}
+			seeds_[code].emplace_back(patPos, offset);
+		}
+	}
+}
+
+void TwoBitPrimerSearcher::searchChunk(const std::string & chrom,
+		const std::string & seq, uint32_t seqStart, uint32_t ownedStart,
+		uint32_t ownedEnd, std::vector<Hit> & hits) const {
+	const uint32_t mask = 32 == 2 * kLen_ ?
+			std::numeric_limits<uint32_t>::max() : (1u << (2 * kLen_)) - 1;
+	//a pattern can be hit by more than one of its seeds so only verify each start once
+	std::set<std::pair<uint32_t, uint32_t>> checked;
+	uint32_t code = 0;
+	uint32_t validLen = 0;
+	for (const auto pos : iter::range<uint32_t>(seq.size())) {
+		auto base = encodeBase(seq[pos]);
+		if (base < 0) {
+			validLen = 0;
+			code = 0;
+			continue;
+		}
+		code = ((code << 2) | static_cast<uint32_t>(base)) & mask;
+		++validLen;
+		if (validLen < kLen_) {
+			continue;
+		}
+		auto search = seeds_.find(code);
+		if (seeds_.end() == search) {
+			continue;
+		}
+		uint32_t seedStart = pos + 1 - kLen_;
+		for (const auto & seed : search->second) {
+			if (seed.second > seedStart) {
+				continue;
+			}
+			uint32_t start = seedStart - seed.second;
+			const auto & pattern = patterns_[seed.first];
+			if (start + pattern.seq_.size() > seq.size()
+					|| seqStart + start < ownedStart || seqStart + start >= ownedEnd
+					|| !checked.emplace(seed.first, start).second) {
+				continue;
+			}
+			uint32_t mismatches = 0;
+			for (const auto patBasePos : iter::range<uint32_t>(pattern.seq_.size())) {
+				if (encodeBase(seq[start + patBasePos]) != encodeBase(pattern.seq_[patBasePos])) {
+					++mismatches;
+					if (mismatches > allowableMismatches_) {
+						break;
+					}
+				}
+			}
+			if (mismatches <= allowableMismatches_) {
+				hits.emplace_back(Hit { pattern.primerPos_, chrom, seqStart + start,
+					static_cast<uint32_t>(seqStart + start + pattern.seq_.size()),
+					pattern.reverseStrand_, mismatches });
+			}
+		}
+	}
+}
+
+std::vector<TwoBitPrimerSearcher::Hit> TwoBitPrimerSearcher::searchGenome(
+		const bfs::path & twoBitFnp, uint32_t numThreads,
+		uint32_t chunkSize) const {
+	bib::files::checkExistenceThrow(twoBitFnp, __PRETTY_FUNCTION__);
+	chunkSize = std::max(chunkSize, maxPatternLen_);
+	struct Chunk {
+		std::string chrom_;
+		uint32_t start_;
+		uint32_t end_;
+	};
+	std::vector<Chunk> chunks;
+	{
+		TwoBit::TwoBitFile tReader(twoBitFnp);
+		auto chromLens = tReader.getSeqLens();
+		auto chroms = getVectorOfMapKeys(chromLens);
+		bib::sort(chroms);
+		for (const auto & chrom : chroms) {
+			for (uint32_t start = 0; start < chromLens.at(chrom); start += chunkSize) {
+				chunks.emplace_back(Chunk { chrom, start,
+					std::min<uint32_t>(start + chunkSize, chromLens.at(chrom)) });
+			}
+		}
+	}
+	std::vector<Hit> allHits;
+	std::mutex hitsMut;
+	std::atomic<uint32_t> nextChunk { 0 };
+	auto searchChunks = [&]() {
+		//each thread needs its own reader
+		TwoBit::TwoBitFile tReader(twoBitFnp);
+		std::vector<Hit> hits;
+		std::string buffer;
+		uint32_t chunkPos = nextChunk++;
+		while (chunkPos < chunks.size()) {
+			const auto & chunk = chunks[chunkPos];
+			//read past the end of the chunk by the longest primer so hits that start in this chunk are complete
+			uint32_t readEnd = std::min<uint32_t>(chunk.end_ + maxPatternLen_ - 1,
+					tReader[chunk.chrom_]->getSeqLen());
+			tReader[chunk.chrom_]->getSequence(buffer, chunk.start_, readEnd);
+			searchChunk(chunk.chrom_, buffer, chunk.start_, chunk.start_, chunk.end_, hits);
+			chunkPos = nextChunk++;
+		}
+		std::lock_guard<std::mutex> lock(hitsMut);
+		addOtherVec(allHits, hits);
+	};
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < std::max<uint32_t>(1, numThreads); ++t) {
+		threads.emplace_back(std::thread(searchChunks));
+	}
+	for (auto & t : threads) {
+		t.join();
+	}
+	//reduce expansions of the same primer hitting the same place to the best hit, sorting also makes the output independent of the number of threads
+	auto hitKeyLess = [this](const Hit & hit1, const Hit & hit2) {
+		const auto & primer1 = primers_[hit1.primerPos_];
+		const auto & primer2 = primers_[hit2.primerPos_];
+		return std::tie(primer1.target_, primer1.forward_, hit1.chrom_, hit1.start_, hit1.end_, hit1.reverseStrand_) <
+				std::tie(primer2.target_, primer2.forward_, hit2.chrom_, hit2.start_, hit2.end_, hit2.reverseStrand_);
+	};
+	std::sort(allHits.begin(), allHits.end(),
+			[&hitKeyLess](const Hit & hit1, const Hit & hit2) {
+				if (hitKeyLess(hit1, hit2)) {
+					return true;
+				}
+				if (hitKeyLess(hit2, hit1)) {
+					return false;
+				}
+				return std::tie(hit1.mismatches_, hit1.primerPos_) < std::tie(hit2.mismatches_, hit2.primerPos_);
+			});
+	std::vector<Hit> ret;
+	for (const auto & hit : allHits) {
+		if (ret.empty() || hitKeyLess(ret.back(), hit)) {
+			ret.emplace_back(hit);
+		}
+	}
+	return ret;
+}
+
+std::vector<TwoBitPrimerSearcher::Amplicon> TwoBitPrimerSearcher::genAmplicons(
+		const std::vector<Hit> & hits, const std::string & target,
+		const std::string & uidPrefix, uint32_t sizeLimit) const {
+	std::vector<Amplicon> ret;
+	std::vector<const Hit *> forwardHits;
+	std::vector<const Hit *> reverseHits;
+	for (const auto & hit : hits) {
+		const auto & primer = primers_[hit.primerPos_];
+		if (primer.target_ != target) {
+			continue;
+		}
+		if (primer.forward_) {
+			forwardHits.emplace_back(&hit);
+		} else {
+			reverseHits.emplace_back(&hit);
+		}
+	}
+	for (const auto & forHit : forwardHits) {
+		for (const auto & revHit : reverseHits) {
+			if (forHit->chrom_ != revHit->chrom_
+					|| forHit->reverseStrand_ != revHit->reverseStrand_) {
+				continue;
+			}
+			//on the plus strand the forward primer comes first, on the minus strand the reverse primer comes first
+			const Hit * first = forHit->reverseStrand_ ? revHit : forHit;
+			const Hit * second = forHit->reverseStrand_ ? forHit : revHit;
+			if (first->end_ > second->start_ || second->end_ - first->start_ > sizeLimit) {
+				continue;
+			}
+			ret.emplace_back(
+					GenomicRegion(uidPrefix, first->chrom_, first->start_, second->end_, forHit->reverseStrand_),
+					GenomicRegion(uidPrefix, first->chrom_, first->end_, second->start_, forHit->reverseStrand_));
+		}
+	}
+	std::sort(ret.begin(), ret.end(),
+			[](const Amplicon & amp1, const Amplicon & amp2) {
+				return std::tie(amp1.region_.chrom_, amp1.region_.start_, amp1.region_.end_) <
+						std::tie(amp2.region_.chrom_, amp2.region_.start_, amp2.region_.end_);
+			});
+	for (const auto pos : iter::range(ret.size())) {
+		ret[pos].region_.uid_ = uidPrefix + "-" + estd::to_string(pos);
+		ret[pos].innerRegion_.uid_ = ret[pos].region_.uid_;
+	}
+	return ret;
+}
+
+}  // namespace bibseq
@@ -0,0 +1,119 @@
+#pragma once
+/*
+ * TwoBitPrimerSearcher.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+
+
+namespace bibseq {
+
+/**@brief Search 2bit genomes for primers directly without an external aligner
+ *
+ * Primers are indexed by k-mer seeds (pigeonhole, allowed mismatches + 1 seeds per primer so any hit within the allowed mismatches shares an exact seed),
+ * each chromosome is read once in chunks spread over threads and both strands are checked against the seeds, candidates are then verified by counting mismatches
+ *
+ */
+class TwoBitPrimerSearcher {
+public:
+
+	struct Primer {
+		Primer(const std::string & target, bool forward, const std::string & seq);
+		std::string target_;
+		bool forward_; /**< whether this is the forward primer of the target */
+		std::string seq_; /**< sequence in the direction of the target, i.e. the reverse primer is reverse complemented */
+	};
+
+	struct Hit {
+		uint32_t primerPos_; /**< position of the primer in primers_ */
+		std::string chrom_;
+		uint32_t start_; /**< zero based start on the plus strand */
+		uint32_t end_; /**< zero based exclusive end on the plus strand */
+		bool reverseStrand_;
+		uint32_t mismatches_;
+	};
+
+	struct Amplicon {
+		Amplicon(const GenomicRegion & region, const GenomicRegion & innerRegion);
+		GenomicRegion region_; /**< region including the primers */
+		GenomicRegion innerRegion_; /**< region with the primers removed */
+	};
+
+	/**@brief Construct with the primers to search for
+	 *
+	 * @param primers the primers, degenerate primers should already be expanded to one Primer per expansion
+	 * @param allowableMismatches the number of mismatches to allow in a hit
+	 */
+	TwoBitPrimerSearcher(const std::vector<Primer> & primers,
+			uint32_t allowableMismatches);
+
+	const std::vector<Primer> primers_;
+	const uint32_t allowableMismatches_;
+
+	/**@brief Search a 2bit genome for all the primers
+	 *
+	 * @param twoBitFnp the genome
+	 * @param numThreads number of threads to search with, work is split into chromosome chunks
+	 * @param chunkSize the size of the chunks, neighboring chunks overlap by the longest primer so no hit is missed at a chunk border
+	 * @return the hits, multiple degenerate expansions hitting the same location are reduced to the best one
+	 */
+	std::vector<Hit> searchGenome(const bfs::path & twoBitFnp,
+			uint32_t numThreads, uint32_t chunkSize = 10000000) const;
+
+	/**@brief Pair up the forward and reverse hits of a target into amplicons
+	 *
+	 * @param hits hits from searchGenome
+	 * @param target the target to pair hits for
+	 * @param uidPrefix prefix for the name of the regions
+	 * @param sizeLimit the max size of the amplicon, primers included
+	 * @return the amplicons in genomic order
+	 */
+	std::vector<Amplicon> genAmplicons(const std::vector<Hit> & hits,
+			const std::string & target, const std::string & uidPrefix,
+			uint32_t sizeLimit) const;
+
+private:
+	struct Pattern {
+		uint32_t primerPos_;
+		bool reverseStrand_;
+		std::string seq_; /**< the primer as it would appear on the plus strand */
+	};
+	std::vector<Pattern> patterns_;
+	uint32_t kLen_;
+	uint32_t maxPatternLen_{0};
+	/**key is the 2bit encoded seed, value is pattern position and the seed's offset into the pattern*/
+	std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint32_t>>> seeds_;
+
+	void searchChunk(const std::string & chrom, const std::string & seq,
+			uint32_t seqStart, uint32_t ownedStart, uint32_t ownedEnd,
+			std::vector<Hit> & hits) const;
+	static int8_t encodeBase(char base);
+};
+
+}  // namespace bibseq
+
+
@@ -136,6 +136,22 @@ struct clusterDownPars {
 	bool writeOutInitalSeqs = false;
 
 	SnapShotsOpts snapShotsOpts_;
+	uint32_t snapShotsMaxQueued = 2;
+	bool writeBinarySeqs = false;
+
+	uint32_t numThreads = 1;
+	bool parallelCollapse = false;
+	bool parallelBinning = false;
+	bool kmerPrefilter = false;
+	uint32_t kmerPrefilterLength = 8;
+	bool editDistPrefilter = false;
+	bool cacheFailedComparisons = false;
+
+	bfs::path alnCacheArchive = "";
+	uint32_t alnCacheArchiveMaxMb = 1024;
+
+	bool streamingCollapse = false;
+	uint32_t streamingBatchSize = 10000;
 };
 
 struct processClustersPars {
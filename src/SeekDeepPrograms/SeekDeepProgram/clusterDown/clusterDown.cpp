@@ -56,8 +56,16 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 		std::cout << "Nucleotide Composition Binning cut offs" << std::endl;
 		printVector(setUp.pars_.colOpts_.nucCompBinOpts_.diffCutOffVec_, ", ", std::cout);
 	}
+	//structured per phase timings, memory and alignment counts, SeekDeepUtils summarizeRunProfiles totals them across runs
+	RunPhaseProfiler profiler("qluster");
+	profiler.meta_["inputFile"] = bib::json::toJson(fullPathToInput);
+	profiler.meta_["numThreads"] = bib::json::toJson(pars.numThreads);
+	auto logPhase = [&setUp,&profiler](const std::string & phaseName, uint64_t countIn){
+		setUp.rLog_.logCurrentTime(phaseName);
+		profiler.startPhase(phaseName, countIn);
+	};
 	setUp.rLog_.setCurrentLapName("initialSetUp");
-	setUp.rLog_.logCurrentTime("Reading In Sequences");
+	logPhase("Reading In Sequences", 0);
 
 	//write out clustering parameters
 
@@ -74,33 +82,145 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 	// read in the sequences
 	SeqInput reader(setUp.pars_.ioOptions_);
 	reader.openIn();
-	auto reads = reader.readAllReads<readObject>();
-	setUp.rLog_.logCurrentTime("Various filtering and little modifications");
-	auto splitOnSize = readVecSplitter::splitVectorBellowLength(reads,
-			pars.smallReadSize);
-	reads = splitOnSize.first;
-	if (!splitOnSize.second.empty()) {
-		SeqOutput::write(splitOnSize.second,SeqIOOptions(setUp.pars_.directoryName_ + "smallReads",
-				setUp.pars_.ioOptions_.outFormat_,setUp.pars_.ioOptions_.out_));
-	}
-	if (setUp.pars_.colOpts_.iTOpts_.removeLowQualityBases_) {
-		readVec::allRemoveLowQualityBases(reads, setUp.pars_.colOpts_.iTOpts_.lowQualityBaseTrim_);
-	}
-	if (setUp.pars_.colOpts_.iTOpts_.adjustHomopolyerRuns_) {
-		readVec::allAdjustHomopolymerRunsQualities(reads);
-	}
+	std::vector<readObject> reads;
 	bool containsCompReads = false;
-	int compCount = 0;
-	readVec::getCountOfReadNameContaining(reads, "_Comp", compCount);
-	if (compCount > 0) {
-		containsCompReads = true;
-	}
-
-	readVecSorter::sortReadVector(reads, pars.sortBy);
-	// get the count of reads read in and the max length so far
-	int counter = readVec::getTotalReadCount(reads);
+	int counter = 0;
 	uint64_t maxSize = 0;
-	readVec::getMaxLength(reads, maxSize);
+	uint64_t inputReadsNumber = 0;
+	std::unique_ptr<StreamingIdenticalCollapser> streamCollapser;
+	std::vector<seqInfo> streamUniqueSeqs;
+	std::unordered_map<std::string, uint32_t> streamCompCounts;
+	bool streamTransformsPerRead = true;
+	bool hasQualTransforms = setUp.pars_.colOpts_.iTOpts_.removeLowQualityBases_
+			|| setUp.pars_.colOpts_.iTOpts_.adjustHomopolyerRuns_;
+	auto transformReads = [&setUp](std::vector<readObject> & readsToTransform){
+		if (setUp.pars_.colOpts_.iTOpts_.removeLowQualityBases_) {
+			readVec::allRemoveLowQualityBases(readsToTransform, setUp.pars_.colOpts_.iTOpts_.lowQualityBaseTrim_);
+		}
+		if (setUp.pars_.colOpts_.iTOpts_.adjustHomopolyerRuns_) {
+			readVec::allAdjustHomopolymerRunsQualities(readsToTransform);
+		}
+	};
+	//the same preprocessing is done whether reading all reads in or streaming them in batches
+	auto preprocessReads = [&pars,&transformReads](std::vector<readObject> & readsToProcess,
+			SeqOutput * smallReadsWriter, bool transform){
+		auto splitOnSize = readVecSplitter::splitVectorBellowLength(readsToProcess,
+				pars.smallReadSize);
+		readsToProcess = splitOnSize.first;
+		if (nullptr != smallReadsWriter) {
+			for (const auto & smallRead : splitOnSize.second) {
+				smallReadsWriter->openWrite(smallRead);
+			}
+		}
+		if (transform) {
+			transformReads(readsToProcess);
+		}
+	};
+	SeqOutput smallReadsWriter(SeqIOOptions(setUp.pars_.directoryName_ + "smallReads",
+			setUp.pars_.ioOptions_.outFormat_,setUp.pars_.ioOptions_.out_));
+	logPhase("Various filtering and little modifications", 0);
+	if (pars.streamingCollapse && !setUp.pars_.ioOptions_.processed_) {
+		//only the unique sequences are kept in memory
+		auto streamReads = [&](SeqOutput * streamSmallReadsWriter){
+			streamCollapser = std::make_unique<StreamingIdenticalCollapser>(pars.qualRep);
+			if (!streamTransformsPerRead) {
+				streamCollapser->setTransformChecks(setUp.pars_.colOpts_.iTOpts_.removeLowQualityBases_,
+						setUp.pars_.colOpts_.iTOpts_.lowQualityBaseTrim_,
+						setUp.pars_.colOpts_.iTOpts_.adjustHomopolyerRuns_);
+			}
+			streamCompCounts.clear();
+			containsCompReads = false;
+			inputReadsNumber = 0;
+			SeqInput streamReader(setUp.pars_.ioOptions_);
+			streamReader.openIn();
+			std::vector<readObject> batch;
+			readObject read;
+			bool moreReads = true;
+			while (moreReads) {
+				batch.clear();
+				while (batch.size() < pars.streamingBatchSize
+						&& (moreReads = streamReader.readNextRead(read))) {
+					batch.emplace_back(read);
+				}
+				preprocessReads(batch, streamSmallReadsWriter, streamTransformsPerRead);
+				inputReadsNumber += batch.size();
+				for (const auto & batchRead : batch) {
+					if (bib::containsSubString(batchRead.seqBase_.name_, "_Comp")) {
+						containsCompReads = true;
+						streamCompCounts[batchRead.seqBase_.seq_] += batchRead.seqBase_.cnt_;
+					}
+					streamCollapser->addRead(batchRead.seqBase_);
+				}
+			}
+		};
+		//the quality transforms are done once per unique sequence rather than on every read when that gives the same result
+		streamTransformsPerRead = !hasQualTransforms;
+		streamReads(&smallReadsWriter);
+		if (!streamTransformsPerRead) {
+			uint32_t nonCommuting = streamCollapser->numberOfNonCommutingUniques();
+			bool transformsMergeUniques = false;
+			std::vector<readObject> uniqueReads;
+			if (0 == nonCommuting) {
+				for (const auto & uniqueSeq : streamCollapser->getUniqueSeqs()) {
+					uniqueReads.emplace_back(uniqueSeq);
+				}
+				transformReads(uniqueReads);
+				//if the transforms make two unique sequences identical their reads would have been collapsed together
+				std::unordered_set<std::string> transformedSeqs;
+				for (const auto & uniqueRead : uniqueReads) {
+					if (!transformedSeqs.emplace(uniqueRead.seqBase_.seq_).second) {
+						transformsMergeUniques = true;
+						break;
+					}
+				}
+			}
+			if (nonCommuting > 0 || transformsMergeUniques) {
+				std::stringstream transformWarning;
+				transformWarning << "Low quality base removal/homopolymer run quality adjustment doesn't give the same result done once per unique sequence";
+				if (nonCommuting > 0) {
+					transformWarning << " (reads differ in quality for " << nonCommuting << " unique sequences)";
+				} else {
+					transformWarning << " (it makes unique sequences identical)";
+				}
+				transformWarning << ", re-reading and doing it on every read";
+				std::cerr << bib::bashCT::red << transformWarning.str() << bib::bashCT::reset << std::endl;
+				setUp.rLog_ << transformWarning.str() << "\n";
+				streamTransformsPerRead = true;
+				streamReads(nullptr);
+			} else {
+				for (const auto & uniqueRead : uniqueReads) {
+					streamUniqueSeqs.emplace_back(uniqueRead.seqBase_);
+				}
+			}
+		}
+		if (streamTransformsPerRead) {
+			streamUniqueSeqs = streamCollapser->getUniqueSeqs();
+		}
+		for (const auto & uniqueSeq : streamUniqueSeqs) {
+			maxSize = std::max<uint64_t>(maxSize, uniqueSeq.seq_.size());
+		}
+		//comp reads were counted by sequence as read in, the unique names are only set once all reads are in
+		std::unordered_map<std::string, uint32_t> streamCompCountsByName;
+		for (const auto & compCount : streamCompCounts) {
+			streamCompCountsByName[streamCollapser->getUniqueName(compCount.first)] += compCount.second;
+		}
+		streamCompCounts = streamCompCountsByName;
+		counter = streamCollapser->numberOfReads();
+	} else {
+		reads = reader.readAllReads<readObject>();
+		preprocessReads(reads, &smallReadsWriter, true);
+		inputReadsNumber = reads.size();
+		int compCount = 0;
+		readVec::getCountOfReadNameContaining(reads, "_Comp", compCount);
+		if (compCount > 0) {
+			containsCompReads = true;
+		}
+
+		readVecSorter::sortReadVector(reads, pars.sortBy);
+		// get the count of reads read in and the max length so far
+		counter = readVec::getTotalReadCount(reads);
+		readVec::getMaxLength(reads, maxSize);
+	}
 	std::vector<readObject> refSequences;
 	if (setUp.pars_.refIoOptions_.firstName_ != "") {
 		refSequences = SeqInput::getReferenceSeq(setUp.pars_.refIoOptions_, maxSize);
@@ -108,7 +228,7 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 	maxSize = maxSize * 2;
 	// calculate the runCutoff if necessary
 	processRunCutoff(setUp.pars_.colOpts_.kmerOpts_.runCutOff_, setUp.pars_.colOpts_.kmerOpts_.runCutOffString_,
-			readVec::getTotalReadCount(reads));
+			counter);
 	if (setUp.pars_.verbose_ && !pars.onPerId) {
 		std::cout << "Kmer Low Frequency Error Cut off Is: " << setUp.pars_.colOpts_.kmerOpts_.runCutOff_
 				<< std::endl;
@@ -125,17 +245,24 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 	setUp.rLog_ << "Reading clusters from " << setUp.pars_.ioOptions_.firstName_ << " "
 			<< setUp.pars_.ioOptions_.secondName_ << "\n";
 	setUp.rLog_ << "Read in " << counter << " reads" << "\n";
-	setUp.rLog_.logCurrentTime("Collapsing to unique sequences");
+	logPhase("Collapsing to unique sequences", counter);
 	// create cluster vector
 	std::vector<identicalCluster> identicalClusters;
 	std::vector<cluster> clusters;
 	if (setUp.pars_.ioOptions_.processed_) {
 		clusters = baseCluster::convertVectorToClusterVector<cluster>(reads);
+	} else if (nullptr != streamCollapser) {
+		clusters.reserve(streamUniqueSeqs.size());
+		for (const auto & uniqueSeq : streamUniqueSeqs) {
+			clusters.emplace_back(uniqueSeq);
+		}
 	} else {
 		identicalClusters = clusterCollapser::collapseIdenticalReads(reads,
 				pars.qualRep);
+		//construct in place rather than copying a temporary cluster for every unique sequence
+		clusters.reserve(identicalClusters.size());
 		for (const auto & read : identicalClusters) {
-			clusters.push_back(cluster(read.seqBase_));
+			clusters.emplace_back(read.seqBase_);
 		}
 		//clusters = baseCluster::convertVectorToClusterVector<cluster>(identicalClusters);
 	}
@@ -144,12 +271,16 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 		std::cout << "Unique clusters numbers: " << clusters.size() << std::endl;
 	}
 	setUp.rLog_ << "Unique clusters numbers: " << clusters.size() << "\n";
-	std::sort(clusters.begin(), clusters.end());
+	//sort positions and then move each cluster once rather than swapping whole clusters while sorting
+	ClusterSortOrder::applyOrder(clusters, ClusterSortOrder::genOrder(clusters,
+			[](const cluster & clus1, const cluster & clus2) {
+				return clus1 < clus2;
+			}));
 	//readVecSorter::sortReadVector(clusters, sortBy);
-	setUp.rLog_.logCurrentTime("Indexing kmers");
+	logPhase("Indexing kmers", clusters.size());
 	KmerMaps kMaps = indexKmers(clusters, setUp.pars_.colOpts_.kmerOpts_.kLength_, setUp.pars_.colOpts_.kmerOpts_.runCutOff_,
 			setUp.pars_.colOpts_.kmerOpts_.kmersByPosition_, setUp.pars_.expandKmerPos_, setUp.pars_.expandKmerSize_);
-	setUp.rLog_.logCurrentTime("Creating aligner");
+	logPhase("Creating aligner", clusters.size());
 	// create aligner class object
 	aligner alignerObj(maxSize,
 			setUp.pars_.gapInfo_, setUp.pars_.scoring_, kMaps,
@@ -177,7 +308,7 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 		}
 		std::cout << alignerObj.parts_.gapScores_.toJson() << std::endl;
 	}
-	setUp.rLog_.logCurrentTime("Reading in previous alignments");
+	logPhase("Reading in previous alignments", clusters.size());
 	alignerObj.processAlnInfoInput(setUp.pars_.alnInfoDirName_, setUp.pars_.verbose_);
 	if(setUp.pars_.verbose_){
 		uint32_t alignmentsReadIn = 0;
@@ -191,7 +322,23 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 		std::cout << "Local Alignments Holders: " << alignerObj.alnHolder_.localHolder_.size() << std::endl;
 		std::cout << "Read in: " << alignmentsReadIn << "alignments" << std::endl;
 	}
-	setUp.rLog_.logCurrentTime("Removing singlets");
+	std::unique_ptr<AlnCacheArchive> alnArchive;
+	if ("" != pars.alnCacheArchive) {
+		logPhase("Reading in alignment cache archive", clusters.size());
+		alnArchive = std::make_unique<AlnCacheArchive>(pars.alnCacheArchive,
+				static_cast<uint64_t>(pars.alnCacheArchiveMaxMb) * 1024 * 1024);
+		//only the alignments involving these input sequences are loaded so alignments no longer used age out of the archive
+		std::unordered_set<std::string> inputSeqs;
+		for (const auto & clus : clusters) {
+			inputSeqs.emplace(clus.seqBase_.seq_);
+		}
+		auto alnsLoaded = alnArchive->load(alignerObj, inputSeqs);
+		setUp.rLog_ << "Alignments loaded from archive: " << alnsLoaded << "\n";
+		if (setUp.pars_.verbose_) {
+			std::cout << "Alignments loaded from archive: " << alnsLoaded << std::endl;
+		}
+	}
+	logPhase("Removing singlets", clusters.size());
 	collapser collapserObj = collapser(setUp.pars_.colOpts_);
 
 	uint32_t singletonNum = 0;
@@ -214,20 +361,133 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 			std::cout << "Removed " << singletons.size() << " singlets" << std::endl;
 		}
 	}
-	setUp.rLog_.logCurrentTime("Running initial clustering");
+	//set up multi-threaded clustering
+	ParallelCollapser parallelCollapserObj(setUp.pars_.colOpts_, pars.numThreads);
+	parallelCollapserObj.kmerPrefilter_ = pars.kmerPrefilter;
+	parallelCollapserObj.kmerPrefilterLength_ = pars.kmerPrefilterLength;
+	parallelCollapserObj.editDistPrefilter_ = pars.editDistPrefilter;
+	parallelCollapserObj.cacheFailedComparisons_ = pars.cacheFailedComparisons;
+	profiler.setAlignmentCounter([&alignerObj,&parallelCollapserObj](){
+		RunPhaseProfiler::AlignmentCounts alnCounts;
+		const auto & counts = parallelCollapserObj.counts_;
+		alnCounts.performed_ = alignerObj.numberOfAlingmentsDone_;
+		//the pooled aligners' alignments aren't added to alignerObj's count, on one thread they're already in it
+		if (nullptr == parallelCollapserObj.singleAligner_) {
+			alnCounts.performed_ += counts.alignmentsDone_ + counts.consensusAlignmentsDone_;
+		}
+		alnCounts.lookups_ = counts.aligned_;
+		alnCounts.lookupsAligned_ = counts.alignmentsDone_;
+		return alnCounts;
+	});
+	bool usePrefilters = pars.kmerPrefilter || pars.editDistPrefilter || pars.cacheFailedComparisons;
+	//binned runs keep collapser's bins unless the parallel collapser's own bins are asked for, they can differ from collapser's
+	bool useBinning = setUp.pars_.colOpts_.nucCompBinOpts_.useNucComp_
+			|| setUp.pars_.colOpts_.kmerBinOpts_.useKmerBinning_;
+	//the parallel collapser is only used when asked for since its clusters can differ from collapser's, it's used whatever the number of threads so they don't depend on --numThreads
+	bool runInParallel = pars.parallelCollapse
+			&& (!useBinning || pars.parallelBinning)
+			&& parallelCollapserObj.canHandle(pars.onPerId);
+	if ((usePrefilters || pars.mapBackSinglets || pars.parallelBinning) && !runInParallel) {
+		std::cerr << bib::bashCT::red
+				<< "Warning, --kmerPrefilter, --editDistPrefilter, --cacheFailedComparisons, --mapBackSinglets and --parallelBinning need --parallelCollapse, and percent identity clustering, --noAlignCompare and binning without --parallelBinning can't be done by it, clustering without them"
+				<< bib::bashCT::reset << std::endl;
+	}
+	//snapshots are taken by whichever collapser runs so turning them on doesn't change the clusters
+	std::unique_ptr<SnapshotWriter> snapshotWriter;
+	if (runInParallel && pars.snapShotsOpts_.snapShots_) {
+		snapshotWriter = std::make_unique<SnapshotWriter>(setUp.pars_.directoryName_,
+				pars.snapShotsMaxQueued);
+		parallelCollapserObj.snapshots_ = snapshotWriter.get();
+	}
+	//on one thread everything is run on alignerObj itself so its alignment cache keeps everything without a pool
+	bool usePool = runInParallel && pars.numThreads > 1;
+	if (runInParallel && !usePool) {
+		parallelCollapserObj.singleAligner_ = &alignerObj;
+	}
+	std::unique_ptr<concurrent::AlignerPool> alnPool;
+	if (usePool) {
+		alnPool = std::make_unique<concurrent::AlignerPool>(alignerObj, pars.numThreads);
+		alnPool->initAligners();
+		if (setUp.pars_.writingOutAlnInfo_) {
+			alnPool->outAlnDir_ = setUp.pars_.outAlnInfoDirName_;
+		} else if (nullptr != alnArchive) {
+			//the pool only hands back its aligners' alignments by writing them out
+			alnPool->outAlnDir_ = bib::files::make_path(setUp.pars_.directoryName_, "poolAlnCache").string();
+		}
+	}
+	logPhase("Running initial clustering", clusters.size());
 	//run clustering
 	pars.snapShotsOpts_.snapShotsDirName_ = "firstSnaps";
-	collapserObj.runFullClustering(clusters, pars.intialParameters,
-			pars.binIteratorMap, alignerObj, setUp.pars_.directoryName_,
-			setUp.pars_.ioOptions_, setUp.pars_.refIoOptions_, pars.snapShotsOpts_);
+	parallelCollapserObj.snapshotsDirName_ = pars.snapShotsOpts_.snapShotsDirName_;
+	if (runInParallel && useBinning) {
+		parallelCollapserObj.runBinnedClustering(clusters, pars.binIteratorMap,
+				pars.intialParameters, alnPool.get());
+	} else if (runInParallel) {
+		parallelCollapserObj.runFullClustering(clusters, pars.intialParameters, alnPool.get());
+	} else {
+		collapserObj.runFullClustering(clusters, pars.intialParameters,
+				pars.binIteratorMap, alignerObj, setUp.pars_.directoryName_,
+				setUp.pars_.ioOptions_, setUp.pars_.refIoOptions_, pars.snapShotsOpts_);
+	}
 	//run again with singlets if needed
 	if (!pars.startWithSingles && !pars.leaveOutSinglets) {
-		setUp.rLog_.logCurrentTime("Running singlet clustering");
-		addOtherVec(clusters, singletons);
 		pars.snapShotsOpts_.snapShotsDirName_ = "secondSnaps";
-		collapserObj.runFullClustering(clusters, pars.iteratorMap,
-				pars.binIteratorMap, alignerObj, setUp.pars_.directoryName_,
-				setUp.pars_.ioOptions_, setUp.pars_.refIoOptions_, pars.snapShotsOpts_);
+		parallelCollapserObj.snapshotsDirName_ = pars.snapShotsOpts_.snapShotsDirName_;
+		if (runInParallel && pars.mapBackSinglets && !pars.iteratorMap.iters_.empty()) {
+			logPhase("Mapping back singlets", clusters.size() + singletons.size());
+			auto singletNumber = singletons.size();
+			auto mapped = parallelCollapserObj.mapBackSinglets(clusters, singletons,
+					pars.iteratorMap.iters_.rbegin()->second, pars.iteratorMap, alnPool.get());
+			setUp.rLog_ << "Singlets mapped back: " << mapped << " of " << singletNumber << "\n";
+			if (setUp.pars_.verbose_) {
+				std::cout << "Singlets mapped back: " << mapped << " of " << singletNumber << std::endl;
+			}
+		} else {
+			logPhase("Running singlet clustering", clusters.size() + singletons.size());
+			addOtherVec(clusters, singletons);
+			if (runInParallel && useBinning) {
+				parallelCollapserObj.runBinnedClustering(clusters, pars.binIteratorMap,
+						pars.iteratorMap, alnPool.get());
+			} else if (runInParallel) {
+				parallelCollapserObj.runFullClustering(clusters, pars.iteratorMap, alnPool.get());
+			} else {
+				collapserObj.runFullClustering(clusters, pars.iteratorMap,
+						pars.binIteratorMap, alignerObj, setUp.pars_.directoryName_,
+						setUp.pars_.ioOptions_, setUp.pars_.refIoOptions_, pars.snapShotsOpts_);
+			}
+		}
+	}
+	if (usePrefilters && runInParallel) {
+		const auto & counts = parallelCollapserObj.counts_;
+		auto compared = counts.aligned_ + counts.skipped_ + counts.editSkipped_ + counts.cachedFailures_;
+		setUp.rLog_ << "Prefilters: aligned " << counts.aligned_ << ", k-mer skipped "
+				<< counts.skipped_ << " ("
+				<< getPercentageString(counts.skipped_, compared)
+				<< "), edit distance skipped " << counts.editSkipped_ << " ("
+				<< getPercentageString(counts.editSkipped_, compared)
+				<< "), already failed skipped " << counts.cachedFailures_ << " ("
+				<< getPercentageString(counts.cachedFailures_, compared)
+				<< "), iterations not filtered: " << counts.unfilteredIterations_ << "\n";
+		if (setUp.pars_.verbose_) {
+			std::cout << "Prefilters: aligned " << counts.aligned_ << ", k-mer skipped "
+					<< counts.skipped_ << ", edit distance skipped " << counts.editSkipped_
+					<< ", already failed skipped " << counts.cachedFailures_
+					<< ", iterations not filtered: "
+					<< counts.unfilteredIterations_ << std::endl;
+		}
+	}
+	//the writer keeps writing the queued snapshots while the rest of the run goes on
+	parallelCollapserObj.snapshots_ = nullptr;
+	if (usePool) {
+		//destroying the pool dumps each thread's alignments, read them back in so the rest of the run and the final alignment cache has them
+		alnPool.reset();
+		if (setUp.pars_.writingOutAlnInfo_) {
+			alignerObj.processAlnInfoInput(setUp.pars_.outAlnInfoDirName_, setUp.pars_.verbose_);
+		} else if (nullptr != alnArchive) {
+			auto poolAlnDir = bib::files::make_path(setUp.pars_.directoryName_, "poolAlnCache");
+			alignerObj.processAlnInfoInput(poolAlnDir.string(), setUp.pars_.verbose_);
+			bfs::remove_all(poolAlnDir);
+		}
 	}
 
 	//remove reads if they are made up of reads only in one direction
@@ -255,20 +515,37 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 		}
 	}
 
-	readVecSorter::sortReadVector(clusters, "totalCount");
+	//one sort of positions in readVecSorter::sort's order with the total count order breaking ties, rather than two sorts of the clusters
+	ClusterSortOrder::applyOrder(clusters, ClusterSortOrder::genOrder(clusters,
+			[](const cluster & clus1, const cluster & clus2) {
+				if (clus2 < clus1) {
+					return true;
+				}
+				if (clus1 < clus2) {
+					return false;
+				}
+				return ClusterSortOrder::totalCountFirst(clus1, clus2);
+			}));
 	std::string seqName = bfs::basename(setUp.pars_.ioOptions_.firstName_);
-	readVecSorter::sort(clusters);
 	renameReadNames(clusters, seqName, true, false, false);
 
 
 	if (setUp.pars_.chiOpts_.checkChimeras_) {
-		setUp.rLog_.logCurrentTime("Checking chimeras");
+		logPhase("Checking chimeras", clusters.size());
 		std::ofstream chimerasInfoFile;
 		openTextFile(chimerasInfoFile,
 				setUp.pars_.directoryName_ + "chimeraNumberInfo.txt", ".txt", false, false);
 		chimerasInfoFile << "#chimericClusters\t#chimericReads" << std::endl;
 		setUp.pars_.chiOpts_.chiOverlap_.largeBaseIndel_ = .99;
 
+		if (pars.numThreads > 1) {
+			//do markChimeras' alignments ahead of time on several threads so it only has to look them up
+			concurrent::AlignerPool chiAlnPool(alignerObj, pars.numThreads);
+			chiAlnPool.initAligners();
+			auto chiAlnsCached = parallelCollapserObj.cacheChimeraAlignments(clusters,
+					setUp.pars_.chiOpts_.parentFreqs_, alignerObj, &chiAlnPool);
+			setUp.rLog_ << "Chimera alignments done ahead of time: " << chiAlnsCached << "\n";
+		}
 //		collapserObj.opts_.verboseOpts_.verbose_ = true;
 //		collapserObj.opts_.verboseOpts_.debug_ = true;
 		auto chiInfoTab = collapserObj.markChimeras(clusters, alignerObj,
@@ -296,7 +573,7 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 	}
 
 	if (pars.collapsingTandems) {
-		setUp.rLog_.logCurrentTime("Collapsing tandems");
+		logPhase("Collapsing tandems", clusters.size());
 		SeqOutput::write(clusters,
 				SeqIOOptions(
 						setUp.pars_.directoryName_
@@ -314,14 +591,33 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 		std::cout << "Collapsed down to " << clusters.size() << " clusters"
 				<< std::endl;
 	}
-	setUp.rLog_.logCurrentTime("Writing outputs");
+	logPhase("Writing outputs", clusters.size());
 	if (setUp.pars_.refIoOptions_.firstName_ == "") {
 		profiler::getFractionInfoCluster(clusters, setUp.pars_.directoryName_,
 				"outputInfo");
 	} else {
+		if (pars.numThreads > 1) {
+			//align the clusters to the references ahead of time on several threads so the comparison only has to look them up
+			concurrent::AlignerPool refAlnPool(alignerObj, pars.numThreads);
+			refAlnPool.initAligners();
+			auto refAlnsCached = ParallelCollapser::cacheReferenceAlignments(clusters,
+					refSequences, setUp.pars_.local_, alignerObj, refAlnPool, pars.numThreads);
+			setUp.rLog_ << "Reference alignments done ahead of time: " << refAlnsCached << "\n";
+		}
+		auto refAlnsBefore = alignerObj.numberOfAlingmentsDone_;
 		profiler::getFractionInfoCluster(clusters, setUp.pars_.directoryName_,
 				"outputInfo", setUp.pars_.refIoOptions_.firstName_.string(), alignerObj,
 				setUp.pars_.local_);
+		if (pars.numThreads > 1) {
+			//anything aligned here missed the cache, e.g. if the comparison aligned the other way round
+			auto refAlnsMissed = alignerObj.numberOfAlingmentsDone_ - refAlnsBefore;
+			setUp.rLog_ << "Reference alignments not found in the cache: " << refAlnsMissed << "\n";
+			if (refAlnsMissed > 0) {
+				std::cerr << bib::bashCT::red << "Warning, " << refAlnsMissed
+						<< " reference alignments weren't found in the cache and were aligned again"
+						<< bib::bashCT::reset << std::endl;
+			}
+		}
 	}
 	std::ofstream startingInfo;
 	openTextFile(startingInfo, setUp.pars_.directoryName_ + "startingInfo.txt", ".txt",
@@ -358,55 +654,144 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 		}
 	}
 
-	SeqOutput::write(clusters,
-			SeqIOOptions(
-					setUp.pars_.directoryName_ + setUp.pars_.ioOptions_.out_.outFilename_.string(),
-					setUp.pars_.ioOptions_.outFormat_,setUp.pars_.ioOptions_.out_));
+	SeqIOOptions finalOutOpts(
+			setUp.pars_.directoryName_ + setUp.pars_.ioOptions_.out_.outFilename_.string(),
+			setUp.pars_.ioOptions_.outFormat_, setUp.pars_.ioOptions_.out_);
+	SeqOutput::write(clusters, finalOutOpts);
+	if (pars.writeBinarySeqs) {
+		//written after the text output so it's never older than it, processClusters only uses it when it isn't
+		BinarySeqContainer::write(clusters,
+				BinarySeqContainer::genFnp(finalOutOpts.out_.outName()), true,
+				setUp.pars_.ioOptions_.out_.overWriteFile_);
+	}
 	if(pars.writeOutFinalInternalSnps){
-		setUp.rLog_.logCurrentTime("Calling internal snps");
+		logPhase("Calling internal snps", clusters.size());
 		std::string snpDir = bib::files::makeDir(setUp.pars_.directoryName_,
 				bib::files::MkdirPar("internalSnpInfo", false)).string();
-		for (const auto & readPos : iter::range(clusters.size())) {
-			std::unordered_map<uint32_t,
-					std::unordered_map<char, std::vector<baseReadObject>>>mismatches;
-
-			for (const auto & subReadPos : iter::range(
-							clusters[readPos].reads_.size())) {
-				const auto & subRead = clusters[readPos].reads_[subReadPos];
-				alignerObj.alignCacheGlobal(clusters[readPos], subRead);
+		VecStr snpColumns {"refPos", "refBase", "seqBase", "freq",
+			"fraction", "seqs", "clusterName"};
+		//the rows for each cluster, filled in by whichever thread calls the cluster and written out in cluster order
+		std::vector<std::string> snpRowsPerCluster(clusters.size());
+		std::vector<uint32_t> snpRowCountsPerCluster(clusters.size(), 0);
+		auto callInternalSnps = [&clusters,&snpRowsPerCluster,&snpRowCountsPerCluster](uint32_t readPos, aligner & currentAligner){
+			const auto & clus = clusters[readPos];
+			//a mismatch is just the position, base and which sub read, names are only looked up when writing
+			struct SnpEvent {
+				uint32_t refPos_;
+				char seqBase_;
+				uint32_t subReadPos_;
+			};
+			std::vector<SnpEvent> events;
+			//counts per position for A, C, G, T and any other base
+			std::vector<std::array<double, 5>> baseCounts(clus.seqBase_.seq_.size(), std::array<double, 5>{{0, 0, 0, 0, 0}});
+			auto baseIndex = [](char base) -> uint32_t {
+				switch (base) {
+				case 'A':
+					return 0;
+				case 'C':
+					return 1;
+				case 'G':
+					return 2;
+				case 'T':
+					return 3;
+				default:
+					return 4;
+				}
+			};
+			for (const auto & subReadPos : iter::range<uint32_t>(clus.reads_.size())) {
+				const auto & subRead = clus.reads_[subReadPos];
+				currentAligner.alignCacheGlobal(clus, subRead);
 				//count gaps and mismatches and get identity
-				alignerObj.profilePrimerAlignment(clusters[readPos], subRead);
-				for (const auto & m : alignerObj.comp_.distances_.mismatches_) {
-					mismatches[m.second.refBasePos][m.second.seqBase].emplace_back(
-							subRead->seqBase_);
+				currentAligner.profilePrimerAlignment(clus, subRead);
+				for (const auto & m : currentAligner.comp_.distances_.mismatches_) {
+					events.emplace_back(SnpEvent{static_cast<uint32_t>(m.second.refBasePos), m.second.seqBase, subReadPos});
+					baseCounts[m.second.refBasePos][baseIndex(m.second.seqBase)] += subRead->seqBase_.cnt_;
 				}
 			}
-			table misTab {VecStr {"refPos", "refBase", "seqBase", "freq",
-					"fraction", "seqs", "clusterName"}};
-			for (const auto & m : mismatches) {
-				for (const auto & seqM : m.second) {
-					double totalCount = 0;
-					for(const auto & read : seqM.second) {
-						totalCount += read.seqBase_.cnt_;
+			std::stable_sort(events.begin(), events.end(),
+					[](const SnpEvent & event1, const SnpEvent & event2) {
+						if (event1.refPos_ == event2.refPos_) {
+							return event1.seqBase_ < event2.seqBase_;
+						}
+						return event1.refPos_ < event2.refPos_;
+					});
+			std::stringstream rows;
+			auto eventIter = events.begin();
+			while (eventIter != events.end()) {
+				auto groupEnd = std::find_if(eventIter, events.end(),
+						[&eventIter](const SnpEvent & event) {
+							return event.refPos_ != eventIter->refPos_ || event.seqBase_ != eventIter->seqBase_;
+						});
+				double totalCount = 0;
+				if (4 == baseIndex(eventIter->seqBase_)) {
+					//other bases share a count slot so sum this base on its own
+					for (auto groupIter = eventIter; groupIter != groupEnd; ++groupIter) {
+						totalCount += clus.reads_[groupIter->subReadPos_]->seqBase_.cnt_;
 					}
-					misTab.content_.emplace_back(
-							toVecStr(m.first, clusters[readPos].seqBase_.seq_[m.first],
-									seqM.first, totalCount,
-									totalCount / clusters[readPos].seqBase_.cnt_,
-									vectorToString(readVec::getNames(seqM.second), ","),
-									clusters[readPos].seqBase_.name_)
-					);
+				} else {
+					totalCount = baseCounts[eventIter->refPos_][baseIndex(eventIter->seqBase_)];
+				}
+				VecStr names;
+				for (auto groupIter = eventIter; groupIter != groupEnd; ++groupIter) {
+					names.emplace_back(clus.reads_[groupIter->subReadPos_]->seqBase_.name_);
+				}
+				rows << vectorToString(toVecStr(eventIter->refPos_, clus.seqBase_.seq_[eventIter->refPos_],
+						eventIter->seqBase_, totalCount,
+						totalCount / clus.seqBase_.cnt_,
+						vectorToString(names, ","),
+						clus.seqBase_.name_), "\t") << "\n";
+				++snpRowCountsPerCluster[readPos];
+				eventIter = groupEnd;
+			}
+			snpRowsPerCluster[readPos] = rows.str();
+		};
+		if (pars.numThreads > 1) {
+			std::vector<uint32_t> clusterPositions(clusters.size());
+			std::iota(clusterPositions.begin(), clusterPositions.end(), 0);
+			bib::concurrent::LockableQueue<uint32_t> clusterQueue(clusterPositions);
+			concurrent::AlignerPool snpAlnPool(alignerObj, pars.numThreads);
+			snpAlnPool.initAligners();
+			std::mutex snpAlnsMut;
+			uint64_t snpAlnsAdded = 0;
+			auto callSnpsForClusters = [&clusterQueue,&snpAlnPool,&callInternalSnps,&alignerObj,&snpAlnsMut,&snpAlnsAdded](){
+				uint32_t readPos = 0;
+				auto currentAligner = snpAlnPool.popAligner();
+				while (clusterQueue.getVal(readPos)) {
+					callInternalSnps(readPos, *currentAligner);
 				}
+				//hand the alignments back so --writeOutAlnInfo and --alnCacheArchive keep them
+				std::lock_guard<std::mutex> lock(snpAlnsMut);
+				snpAlnsAdded += ParallelCollapser::addNewAlignments(*currentAligner, alignerObj);
+			};
+			std::vector<std::thread> threads;
+			for (uint32_t t = 0; t < pars.numThreads; ++t) {
+				threads.emplace_back(std::thread(callSnpsForClusters));
+			}
+			for (auto & t : threads) {
+				t.join();
+			}
+			alignerObj.numberOfAlingmentsDone_ += snpAlnsAdded;
+		} else {
+			for (const auto readPos : iter::range<uint32_t>(clusters.size())) {
+				callInternalSnps(readPos, alignerObj);
 			}
-			misTab.sortTable("seqBase", false);
-			misTab.sortTable("refPos", false);
-			misTab.outPutContents(
-					TableIOOpts(OutOptions(snpDir + clusters[readPos].seqBase_.name_,
-							".tab.txt"), "\t", misTab.hasHeader_));
+		}
+		//all clusters go in one table with an index of where each cluster's rows start
+		std::ofstream snpsFile;
+		openTextFile(snpsFile, OutOptions(bib::files::make_path(snpDir, "internalSnps.tab.txt")));
+		std::ofstream snpsIndexFile;
+		openTextFile(snpsIndexFile, OutOptions(bib::files::make_path(snpDir, "internalSnpsIndex.tab.txt")));
+		snpsFile << vectorToString(snpColumns, "\t") << "\n";
+		snpsIndexFile << "clusterName\tbyteOffset\trows" << "\n";
+		for (const auto readPos : iter::range(clusters.size())) {
+			snpsIndexFile << clusters[readPos].seqBase_.name_
+					<< "\t" << snpsFile.tellp()
+					<< "\t" << snpRowCountsPerCluster[readPos] << "\n";
+			snpsFile << snpRowsPerCluster[readPos];
 		}
 	}
 	if (pars.createMinTree) {
-		setUp.rLog_.logCurrentTime("Creating minimum spanning trees");
+		logPhase("Creating minimum spanning trees", clusters.size());
 		std::string minTreeDirname = bib::files::makeDir(setUp.pars_.directoryName_,
 				bib::files::MkdirPar("minTree", false)).string();
 		auto clusSplit = readVecSplitter::splitVectorOnReadFraction(clusters,
@@ -417,9 +802,8 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 		}
 	  std::unordered_map<std::string, std::unique_ptr<aligner>> aligners;
 	  std::mutex alignerLock;
-	  uint32_t numThreads = 2;
 		auto graph = genReadComparisonGraph(tempReads, alignerObj, aligners, alignerLock,
-				numThreads);
+				pars.numThreads);
 		std::vector<std::string> popNames;
 		for (const auto & n : graph.nodes_) {
 			if (n->on_) {
@@ -487,27 +871,82 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 			subClusterWriter.openOut();
 		}
 
-		for (const auto& clus : clusters) {
-			MetaDataInName clusMeta;
-			clusMeta.addMeta("clusterName", clus.seqBase_.name_);
-			uint32_t currentCompAmount = 0;
-			for (const auto & seq : clus.reads_) {
-				auto input = readVec::getReadByName(identicalClusters, seq->seqBase_.name_);
-				for( auto & inputRead : input.reads_){
-					if (bib::containsSubString(inputRead->seqBase_.name_, "_Comp")) {
-						currentCompAmount += inputRead->seqBase_.cnt_;
+		if (nullptr != streamCollapser) {
+			std::unordered_map<std::string, std::string> uniqueNameToClusterName;
+			for (const auto& clus : clusters) {
+				uint32_t currentCompAmount = 0;
+				for (const auto & seq : clus.reads_) {
+					uniqueNameToClusterName[seq->seqBase_.name_] = clus.seqBase_.name_;
+					auto compSearch = streamCompCounts.find(seq->seqBase_.name_);
+					if (streamCompCounts.end() != compSearch) {
+						currentCompAmount += compSearch->second;
+					}
+				}
+				if (containsCompReads) {
+					compStats << clus.seqBase_.name_ << "\t"
+							<< getPercentageString(currentCompAmount, clus.seqBase_.cnt_)
+							<< std::endl;
+				}
+			}
+			if (pars.writeOutInitalSeqs) {
+				//the input reads weren't kept so go back over the input to write out the initial reads
+				SeqInput initialReader(setUp.pars_.ioOptions_);
+				initialReader.openIn();
+				std::vector<readObject> batch;
+				readObject read;
+				bool moreReads = true;
+				while (moreReads) {
+					batch.clear();
+					while (batch.size() < pars.streamingBatchSize
+							&& (moreReads = initialReader.readNextRead(read))) {
+						batch.emplace_back(read);
+					}
+					preprocessReads(batch, nullptr, streamTransformsPerRead);
+					//the reads are looked up by the sequence they were collapsed on and written out transformed
+					std::vector<std::string> batchClusterNames;
+					for (const auto & batchRead : batch) {
+						auto clusterName = uniqueNameToClusterName.find(
+								streamCollapser->getUniqueName(batchRead.seqBase_.seq_));
+						batchClusterNames.emplace_back(
+								uniqueNameToClusterName.end() == clusterName ? "" : clusterName->second);
 					}
-					if(pars.writeOutInitalSeqs){
-						seqInfo subClusCopy = inputRead->seqBase_;
-						clusMeta.resetMetaInName(subClusCopy.name_);
-						subClusterWriter.write(subClusCopy);
+					if (!streamTransformsPerRead) {
+						transformReads(batch);
+					}
+					for (const auto batchPos : iter::range(batch.size())) {
+						if ("" != batchClusterNames[batchPos]) {
+							MetaDataInName clusMeta;
+							clusMeta.addMeta("clusterName", batchClusterNames[batchPos]);
+							seqInfo subClusCopy = batch[batchPos].seqBase_;
+							clusMeta.resetMetaInName(subClusCopy.name_);
+							subClusterWriter.write(subClusCopy);
+						}
 					}
 				}
 			}
-			if (containsCompReads) {
-				compStats << clus.seqBase_.name_ << "\t"
-						<< getPercentageString(currentCompAmount, clus.seqBase_.cnt_)
-						<< std::endl;
+		} else {
+			for (const auto& clus : clusters) {
+				MetaDataInName clusMeta;
+				clusMeta.addMeta("clusterName", clus.seqBase_.name_);
+				uint32_t currentCompAmount = 0;
+				for (const auto & seq : clus.reads_) {
+					auto input = readVec::getReadByName(identicalClusters, seq->seqBase_.name_);
+					for( auto & inputRead : input.reads_){
+						if (bib::containsSubString(inputRead->seqBase_.name_, "_Comp")) {
+							currentCompAmount += inputRead->seqBase_.cnt_;
+						}
+						if(pars.writeOutInitalSeqs){
+							seqInfo subClusCopy = inputRead->seqBase_;
+							clusMeta.resetMetaInName(subClusCopy.name_);
+							subClusterWriter.write(subClusCopy);
+						}
+					}
+				}
+				if (containsCompReads) {
+					compStats << clus.seqBase_.name_ << "\t"
+							<< getPercentageString(currentCompAmount, clus.seqBase_.cnt_)
+							<< std::endl;
+				}
 			}
 		}
 	}
@@ -520,14 +959,27 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 				".tab.txt", false, true);
 		singletonsInfoFile << "readCnt\treadFrac\n";
 		singletonsInfoFile << singletons.size() << "\t"
-				<< singletons.size() / static_cast<double>(reads.size())
+				<< singletons.size() / static_cast<double>(inputReadsNumber)
 				<< std::endl;
 	}
 
 	if (setUp.pars_.writingOutAlnInfo_) {
-		setUp.rLog_.logCurrentTime("Writing previous alignments");
+		logPhase("Writing previous alignments", clusters.size());
 		alignerObj.alnHolder_.write(setUp.pars_.outAlnInfoDirName_, setUp.pars_.verbose_);
 	}
+	if (nullptr != alnArchive) {
+		logPhase("Adding alignments to archive", clusters.size());
+		auto alnsAdded = alnArchive->save(alignerObj);
+		setUp.rLog_ << "Alignments added to archive: " << alnsAdded << "\n";
+		if (setUp.pars_.verbose_) {
+			std::cout << "Alignments added to archive: " << alnsAdded << std::endl;
+		}
+	}
+	if (nullptr != snapshotWriter) {
+		snapshotWriter->finish();
+		setUp.rLog_ << "Snap shots written: " << snapshotWriter->numberWritten()
+				<< ", replaced while waiting to be written: " << snapshotWriter->numberCoalesced() << "\n";
+	}
 	//log number of alignments done
 	setUp.rLog_ << "Number of Alignments Done: "
 			<< alignerObj.numberOfAlingmentsDone_ << "\n";
@@ -537,6 +989,10 @@ int SeekDeepRunner::qluster(const bib::progutils::CmdArgs & inputCommands) {
 		//log time
 		setUp.logRunTime(std::cout);
 	}
+	profiler.meta_["inputReads"] = bib::json::toJson(inputReadsNumber);
+	profiler.meta_["finalClusters"] = bib::json::toJson(static_cast<uint64_t>(clusters.size()));
+	profiler.finish(bib::files::make_path(setUp.pars_.directoryName_, "runProfile.json"),
+			clusters.size());
 
 	return 0;
 }
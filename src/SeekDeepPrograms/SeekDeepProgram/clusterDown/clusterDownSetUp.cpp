@@ -278,8 +278,8 @@ void SeekDeepSetUp::setUpClusterDown(clusterDownPars & pars) {
 
 	setOption(pars.startWithSingles, "--startWithSingles",
 			"Start The Clustering With Singletons, rather then adding them afterwards", false, "Clustering");
-//	setOption(pars.mapBackSinglets, "--mapBackSinglets",
-//				"If Singlets are left out, map them back in for frequency estimates");
+	setOption(pars.mapBackSinglets, "--mapBackSinglets",
+				"Rather than clustering again with the singlets added, add each singlet to the cluster it shares the most k-mers with that passes the last iteration's errors, only the singlets that don't match are clustered again", false, "Clustering");
 	setOption(pars.singletCutOff, "--singletCutOff",
 				"Naturally the cut off for being a singlet is by default 1 but can use --singletCutOff to raise the number", false, "Clustering");
 	setOption(pars.createMinTree, "--createMinTree",
@@ -287,6 +287,7 @@ void SeekDeepSetUp::setUpClusterDown(clusterDownPars & pars) {
 	setOption(pars_.colOpts_.kmerBinOpts_.useKmerBinning_, "--useKmerBinning", "Use Kmer Binning for initial clustering to speed up clustering", false, "Clustering");
 	setOption(pars_.colOpts_.kmerBinOpts_.kmerCutOff_, "--kmerCutOff", "kmer Cut Off for when --useKmerBinning is used", false, "Clustering");
 	setOption(pars_.colOpts_.kmerBinOpts_.kCompareLen_, "--kCompareLen", "kmer Compare Length for when bining by kmers first for when --useKmerBinning is used", false, "Clustering");
+	setOption(pars.parallelBinning, "--parallelBinning", "With --parallelCollapse, when binning with --useNucComp or --useKmerBinning, form and collapse the bins with the multi-threaded collapser so the bins are collapsed at the same time, bins are formed from the most abundant cluster down and can differ from the default binning, with several --diffCutOffs the clusters are re-binned and collapsed for each cut off in order", false, "Clustering");
 	setOption(pars.leaveOutSinglets, "--leaveOutSinglets",
 			"Leave out singlet clusters out of all analysis", false, "Clustering");
 	setOption(pars.onPerId, "--onPerId", "Cluster on Percent Identity Instead", false, "OTU Clustering");
@@ -295,7 +296,7 @@ void SeekDeepSetUp::setUpClusterDown(clusterDownPars & pars) {
 	setOption(pars.qualRep, "--qualRep",
 			"Per base quality score calculation for initial unique clusters collapse", false, "Preprocessing");
 	//setOption(pars.extra, "--extra", "Extra");
-	setOption(pars.writeOutFinalInternalSnps, "--writeOutFinalInternalSnps", "Write out Internal (within the clusters) SNP class, useful for debugging if over collapsing is happening", false, "Additional Output");
+	setOption(pars.writeOutFinalInternalSnps, "--writeOutFinalInternalSnps", "Write out Internal (within the clusters) SNP class, useful for debugging if over collapsing is happening, written to internalSnpInfo/internalSnps.tab.txt with internalSnpsIndex.tab.txt giving where each cluster starts", false, "Additional Output");
 
 	pars_.chiOpts_.checkChimeras_ = true;
 	pars_.chiOpts_.parentFreqs_ = 2;
@@ -307,6 +308,8 @@ void SeekDeepSetUp::setUpClusterDown(clusterDownPars & pars) {
 	setOption(pars_.chiOpts_.keepLowQaulityMismatches_, "--chiKeepLowQaulityMismatches", "When marking chimeras also consider low quality mismatches, these are removed by default to prevent errors from incorrectly mising chimeras but could also hurt chimera marking", false, "Chimeras");
 
 	setOption(pars.snapShotsOpts_.snapShots_, "--snapShots", "Output Snap Shots of clustering results after each iteration", false, "Additional Output");
+	setOption(pars.snapShotsMaxQueued, "--snapShotsMaxQueued", "When clustering with the parallel collapser snap shots are written in the background, when more than this many are waiting the newest replaces the last waiting one rather than holding up clustering", false, "Additional Output");
+	setOption(pars.writeBinarySeqs, "--writeBinary", "Also write the final clusters to a binary container (.sdseq) next to the output file, processClusters reads the longest sequence length from it instead of parsing the clusters for sizing its aligner, the samples themselves are still read from the regular output", false, "Additional Output");
 	setOption(pars.sortBy, "--sortBy", "Sort Clusters By");
 	pars.additionalOut = setOption(pars.additionalOutLocationFile,
 			"--additionalOut", "Additional out filename for sorting final results", false, "Additional Output");
@@ -314,9 +317,25 @@ void SeekDeepSetUp::setUpClusterDown(clusterDownPars & pars) {
 
 	setOption(pars_.colOpts_.alignOpts_.noAlign_, "--noAlignCompare",
 			"Do comparisons without globally aligning", false, "Alignment");
+	setOption(pars.alnCacheArchive, "--alnCacheArchive",
+			"A directory of a binary alignment cache to read from and add to, can be shared by several qluster runs at once, e.g. all the replicates of a target", false, "Alignment");
+	setOption(pars.alnCacheArchiveMaxMb, "--alnCacheArchiveMaxMb",
+			"When the --alnCacheArchive gets larger than this many megabytes the least recently used alignments are removed", false, "Alignment");
 	processSkipOnNucComp();
+	setOption(pars.numThreads, "--numThreads", "Number of threads to use when caching alignments and creating the --createMinTree graph, and when comparing clusters with --parallelCollapse", false, "Clustering");
+	setOption(pars.parallelCollapse, "--parallelCollapse", "Cluster with the multi-threaded collapser, each iteration compares every cluster against the clusters as they were at the start of the iteration and then merges, so the clusters can differ from the default collapser that merges each cluster as soon as it finds a match, they are the same for any --numThreads, needed for --kmerPrefilter, --editDistPrefilter, --cacheFailedComparisons, --mapBackSinglets and --parallelBinning", false, "Clustering");
 	setOption(pars_.colOpts_.clusOpts_.converge_, "--converge", "Keep clustering at each iteration until there is no more collapsing, could increase run time significantly", false, "Clustering");
+	setOption(pars.kmerPrefilter, "--kmerPrefilter", "Skip aligning clusters whose shared k-mer counts prove they can't pass an iteration's allowed errors, results are unchanged, only used for iterations that don't allow large indels when end gaps are counted (--countEndGaps) and homopolymers aren't weighed, clusters with bases other than ACGT are only skipped on length", false, "Clustering");
+	setOption(pars.kmerPrefilterLength, "--kmerPrefilterLength", "The k-mer length used by --kmerPrefilter and --mapBackSinglets", false, "Clustering");
+	setOption(pars.editDistPrefilter, "--editDistPrefilter", "Skip aligning clusters whose bit-parallel edit distance is more than an iteration's allowed mismatches and indel bases, results are unchanged, used for the same iterations as --kmerPrefilter, not for clusters with bases other than ACGT", false, "Clustering");
+	setOption(pars.cacheFailedComparisons, "--cacheFailedComparisons", "Remember which cluster pairs failed an iteration's allowed errors and don't re-align them in repeated iterations or --converge reruns unless one of the clusters took in reads since, results are unchanged", false, "Clustering");
+	if ((pars.kmerPrefilter || pars.mapBackSinglets) && (0 == pars.kmerPrefilterLength || pars.kmerPrefilterLength > 32)) {
+		failed_ = true;
+		addWarning("Error, --kmerPrefilterLength should be between 1 and 32, not " + estd::to_string(pars.kmerPrefilterLength));
+	}
 	setOption(pars.writeOutInitalSeqs, "--writeOutInitalSeqs", "Write out the sequences that make up each cluster", false, "Additional Output");
+	setOption(pars.streamingCollapse, "--streamingCollapse", "Collapse identical reads as they are read in rather than reading in all reads first, lowers memory use for large inputs", false, "Preprocessing");
+	setOption(pars.streamingBatchSize, "--streamingBatchSize", "Number of reads to read in at a time when using --streamingCollapse", false, "Preprocessing");
 	pars_.colOpts_.verboseOpts_.verbose_ = pars_.verbose_;
 	pars_.colOpts_.verboseOpts_.debug_ = pars_.debug_;
 	processRefFilename();
@@ -70,6 +70,15 @@ int SeekDeepRunner::processClusters(const bib::progutils::CmdArgs & inputCommand
 	setUp.setUpMultipleSampleCluster(pars);
 	// start a run log
 	setUp.startARunLog(setUp.pars_.directoryName_);
+	//phase timings also go to runProfile.json next to the run log
+	RunPhaseProfiler profiler("processClusters");
+	profiler.meta_["masterDir"] = bib::json::toJson(pars.masterDir);
+	profiler.meta_["numThreads"] = bib::json::toJson(pars.numThreads);
+	auto logPhase = [&setUp,&profiler](const std::string & phaseName, uint64_t countIn){
+		setUp.rLog_.logCurrentTime(phaseName);
+		profiler.startPhase(phaseName, countIn);
+	};
+	logPhase("Reading in samples", 0);
 	// parameters file
 	setUp.writeParametersFile(setUp.pars_.directoryName_ + "parametersUsed.txt",
 			false, false);
@@ -120,6 +129,12 @@ int SeekDeepRunner::processClusters(const bib::progutils::CmdArgs & inputCommand
 	}
 	// get max size for aligner
 	for (const auto& sf : specificFiles) {
+		//the container written by qluster --writeBinary has the max length in its header so the sequences don't need to be parsed
+		if (BinarySeqContainer::hasCurrentContainer(sf)) {
+			BinarySeqContainer container(BinarySeqContainer::genFnp(sf));
+			maxSize = std::max<uint64_t>(maxSize, container.maxLen());
+			continue;
+		}
 		SeqIOOptions inOpts(sf, setUp.pars_.ioOptions_.inFormat_, true);
 		SeqInput reader(inOpts);
 		reader.openIn();
@@ -128,12 +143,20 @@ int SeekDeepRunner::processClusters(const bib::progutils::CmdArgs & inputCommand
 			readVec::getMaxLength(seq, maxSize);
 		}
 	}
+	logPhase("Creating aligner", samplesDirs.size());
 	// create aligner class object
 	aligner alignerObj(maxSize, setUp.pars_.gapInfo_, setUp.pars_.scoring_,
 			KmerMaps(setUp.pars_.colOpts_.kmerOpts_.kLength_),
 			setUp.pars_.qScorePars_, setUp.pars_.colOpts_.alignOpts_.countEndGaps_,
 			setUp.pars_.colOpts_.iTOpts_.weighHomopolyer_);
 	alignerObj.processAlnInfoInput(setUp.pars_.alnInfoDirName_);
+	//the sample clustering threads' aligners are counted separately since their counts aren't added to alignerObj's
+	std::atomic<uint64_t> poolAlignmentsDone { 0 };
+	profiler.setAlignmentCounter([&alignerObj,&poolAlignmentsDone](){
+		RunPhaseProfiler::AlignmentCounts alnCounts;
+		alnCounts.performed_ = alignerObj.numberOfAlingmentsDone_ + poolAlignmentsDone;
+		return alnCounts;
+	});
 
 
 
@@ -156,15 +179,17 @@ int SeekDeepRunner::processClusters(const bib::progutils::CmdArgs & inputCommand
 	//process custom cut offs
 	std::unordered_map<std::string, double> customCutOffsMap = processCustomCutOffs(pars.customCutOffs, samplesDirs, pars.fracCutoff);
 
+	logPhase("Clustering samples", samplesDirs.size());
 	{
 		bib::concurrent::LockableQueue<std::string> sampleQueue(samplesDirs);
 		bibseq::concurrent::AlignerPool alnPool(alignerObj, pars.numThreads);
 		alnPool.initAligners();
 		alnPool.outAlnDir_ = setUp.pars_.outAlnInfoDirName_;
 
-		auto setupClusterSamples = [&sampleQueue, &alnPool,&collapserObj,&pars, &setUp,&expectedSeqs,&sampColl](){
+		auto setupClusterSamples = [&sampleQueue, &alnPool,&collapserObj,&pars, &setUp,&expectedSeqs,&sampColl,&poolAlignmentsDone](){
 			std::string samp = "";
 			auto currentAligner = alnPool.popAligner();
+			auto startAlignmentsDone = currentAligner->numberOfAlingmentsDone_;
 			while(sampleQueue.getVal(samp)){
 				if(setUp.pars_.verbose_){
 					std::cout << "Starting: " << samp << std::endl;
@@ -213,6 +238,7 @@ int SeekDeepRunner::processClusters(const bib::progutils::CmdArgs & inputCommand
 					std::cout << "Ending: " << samp << std::endl;
 				}
 			}
+			poolAlignmentsDone += currentAligner->numberOfAlingmentsDone_ - startAlignmentsDone;
 		};
 		std::vector<std::thread> threads;
 		for(uint32_t t = 0; t < pars.numThreads; ++t){
@@ -223,6 +249,7 @@ int SeekDeepRunner::processClusters(const bib::progutils::CmdArgs & inputCommand
 		}
 	}
 
+	logPhase("Excluding and collapsing low frequency clusters", samplesDirs.size());
 	//read in the dump alignment cache
 	alignerObj.processAlnInfoInput(setUp.pars_.alnInfoDirName_);
 
@@ -277,6 +304,7 @@ int SeekDeepRunner::processClusters(const bib::progutils::CmdArgs & inputCommand
 
 		sampColl.dumpSample(sampleName);
 	}
+	logPhase("Population clustering", samplesDirs.size());
 	if(setUp.pars_.verbose_){
 		std::cout << bib::bashCT::boldGreen("Pop Clustering") << std::endl;
 	}
@@ -292,9 +320,30 @@ int SeekDeepRunner::processClusters(const bib::progutils::CmdArgs & inputCommand
 	}
 
 	if (!expectedSeqs.empty()) {
+		if (pars.numThreads > 1 && !pars.noPopulation) {
+			//align the population clusters to the expected seqs ahead of time on several threads so the comparison only has to look them up
+			concurrent::AlignerPool refAlnPool(alignerObj, pars.numThreads);
+			refAlnPool.initAligners();
+			auto refAlnsCached = ParallelCollapser::cacheReferenceAlignments(
+					sampColl.popCollapse_->collapsed_.clusters_, expectedSeqs, false,
+					alignerObj, refAlnPool, pars.numThreads);
+			setUp.rLog_ << "Reference alignments done ahead of time: " << refAlnsCached << "\n";
+		}
+		auto refAlnsBefore = alignerObj.numberOfAlingmentsDone_;
 		sampColl.comparePopToRefSeqs(expectedSeqs, alignerObj);
+		if (pars.numThreads > 1 && !pars.noPopulation) {
+			//anything aligned here missed the cache, e.g. if the comparison aligned the other way round
+			auto refAlnsMissed = alignerObj.numberOfAlingmentsDone_ - refAlnsBefore;
+			setUp.rLog_ << "Reference alignments not found in the cache: " << refAlnsMissed << "\n";
+			if (refAlnsMissed > 0) {
+				std::cerr << bib::bashCT::red << "Warning, " << refAlnsMissed
+						<< " reference alignments weren't found in the cache and were aligned again"
+						<< bib::bashCT::reset << std::endl;
+			}
+		}
 	}
 
+	logPhase("Writing outputs", samplesDirs.size());
 	sampColl.printSampleCollapseInfo(
 			bib::files::make_path(sampColl.masterOutputDir_,
 					"selectedClustersInfo.tab.txt"));
@@ -389,6 +438,8 @@ int SeekDeepRunner::processClusters(const bib::progutils::CmdArgs & inputCommand
 		std::cout << alignerObj.numberOfAlingmentsDone_ << std::endl;
 		setUp.logRunTime(std::cout);
 	}
+	profiler.finish(bib::files::make_path(setUp.pars_.directoryName_, "runProfile.json"),
+			samplesDirs.size());
 
 	return 0;
 }
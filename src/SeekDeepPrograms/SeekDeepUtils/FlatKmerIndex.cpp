@@ -0,0 +1,221 @@
+/*
+ * FlatKmerIndex.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "FlatKmerIndex.hpp"
+
+namespace bibseq {
+
+FlatKmerIndex::FlatCounts::FlatCounts() :
+		keys_(1024, 0), counts_(1024, 0), mask_(1023) {
+}
+
+void FlatKmerIndex::FlatCounts::add(uint64_t key, uint32_t cnt) {
+	//kept at most half full so probes stay short
+	if ((size_ + 1) * 2 > keys_.size()) {
+		grow();
+	}
+	uint64_t stored = key + 1;
+	uint64_t slot = (stored * 0x9E3779B97F4A7C15ULL) & mask_;
+	while (0 != keys_[slot] && stored != keys_[slot]) {
+		slot = (slot + 1) & mask_;
+	}
+	if (0 == keys_[slot]) {
+		keys_[slot] = stored;
+		++size_;
+	}
+	counts_[slot] += cnt;
+}
+
+uint32_t FlatKmerIndex::FlatCounts::get(uint64_t key) const {
+	uint64_t stored = key + 1;
+	uint64_t slot = (stored * 0x9E3779B97F4A7C15ULL) & mask_;
+	while (0 != keys_[slot]) {
+		if (stored == keys_[slot]) {
+			return counts_[slot];
+		}
+		slot = (slot + 1) & mask_;
+	}
+	return 0;
+}
+
+void FlatKmerIndex::FlatCounts::grow() {
+	std::vector<uint64_t> oldKeys(keys_.size() * 2, 0);
+	std::vector<uint32_t> oldCounts(counts_.size() * 2, 0);
+	oldKeys.swap(keys_);
+	oldCounts.swap(counts_);
+	mask_ = keys_.size() - 1;
+	for (const auto pos : iter::range<uint64_t>(oldKeys.size())) {
+		if (0 != oldKeys[pos]) {
+			uint64_t slot = (oldKeys[pos] * 0x9E3779B97F4A7C15ULL) & mask_;
+			while (0 != keys_[slot]) {
+				slot = (slot + 1) & mask_;
+			}
+			keys_[slot] = oldKeys[pos];
+			counts_[slot] = oldCounts[pos];
+		}
+	}
+}
+
+uint64_t FlatKmerIndex::FlatCounts::size() const {
+	return size_;
+}
+
+uint64_t FlatKmerIndex::FlatCounts::memoryBytes() const {
+	return keys_.capacity() * sizeof(uint64_t) + counts_.capacity() * sizeof(uint32_t);
+}
+
+FlatKmerIndex::FlatKmerIndex(uint32_t kLength, bool expandPos,
+		uint32_t expandSize) :
+		kLength_(kLength), expandPos_(expandPos), expandSize_(expandSize) {
+	if (0 == kLength_ || kLength_ > 24) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error k-mer length should be between 1 and 24, not "
+				<< kLength_ << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+}
+
+bool FlatKmerIndex::packKmer(const std::string & seq, uint32_t pos,
+		uint32_t kLength, uint64_t & packed) {
+	if (static_cast<uint64_t>(pos) + kLength > seq.size()) {
+		return false;
+	}
+	packed = 0;
+	for (uint32_t kPos = pos; kPos < pos + kLength; ++kPos) {
+		uint64_t base = 0;
+		switch (seq[kPos]) {
+		case 'A':
+			base = 0;
+			break;
+		case 'C':
+			base = 1;
+			break;
+		case 'G':
+			base = 2;
+			break;
+		case 'T':
+			base = 3;
+			break;
+		default:
+			return false;
+		}
+		packed = (packed << 2) | base;
+	}
+	return true;
+}
+
+void FlatKmerIndex::addSeq(const std::string & seq, double cnt) {
+	if (seq.size() > std::numeric_limits<uint16_t>::max()) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error sequences can be at most "
+				<< std::numeric_limits<uint16_t>::max() << " bases, not " << seq.size() << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	if (seq.size() < kLength_) {
+		return;
+	}
+	uint32_t readCnt = static_cast<uint32_t>(std::round(cnt));
+	//roll the packed k-mer along the sequence, validBases counts back to the last base other than ACGT
+	uint64_t kMask = (1ULL << (2 * kLength_)) - 1;
+	uint64_t packed = 0;
+	uint32_t validBases = 0;
+	for (uint32_t pos = 0; pos < seq.size(); ++pos) {
+		uint64_t base = 0;
+		bool valid = true;
+		switch (seq[pos]) {
+		case 'A':
+			base = 0;
+			break;
+		case 'C':
+			base = 1;
+			break;
+		case 'G':
+			base = 2;
+			break;
+		case 'T':
+			base = 3;
+			break;
+		default:
+			valid = false;
+			break;
+		}
+		packed = ((packed << 2) | base) & kMask;
+		validBases = valid ? validBases + 1 : 0;
+		if (pos + 1 >= kLength_) {
+			uint32_t kStart = pos + 1 - kLength_;
+			if (validBases >= kLength_) {
+				anywhere_.add(packed, readCnt);
+				if (expandPos_) {
+					//positions have to fit in the key's 16 bits
+					uint32_t windowStart = kStart < expandSize_ ? 0 : kStart - expandSize_;
+					uint32_t windowStop = std::min<uint32_t>(kStart + expandSize_,
+							std::numeric_limits<uint16_t>::max() - 1);
+					for (uint32_t windowPos = windowStart; windowPos <= windowStop; ++windowPos) {
+						byPos_.add((packed << 16) | windowPos, readCnt);
+					}
+				} else {
+					byPos_.add((packed << 16) | kStart, readCnt);
+				}
+			}
+		}
+	}
+}
+
+uint32_t FlatKmerIndex::countAt(const std::string & seq, uint32_t pos) const {
+	uint64_t packed = 0;
+	if (pos > std::numeric_limits<uint16_t>::max() || !packKmer(seq, pos, kLength_, packed)) {
+		return 0;
+	}
+	return byPos_.get((packed << 16) | pos);
+}
+
+uint32_t FlatKmerIndex::countAnywhere(const std::string & seq, uint32_t pos) const {
+	uint64_t packed = 0;
+	if (!packKmer(seq, pos, kLength_, packed)) {
+		return 0;
+	}
+	return anywhere_.get(packed);
+}
+
+bool FlatKmerIndex::isLowFrequency(const std::string & seq, uint32_t pos,
+		bool byPosition, uint32_t cutOff) const {
+	return (byPosition ? countAt(seq, pos) : countAnywhere(seq, pos)) <= cutOff;
+}
+
+uint64_t FlatKmerIndex::numberOfKmersAnywhere() const {
+	return anywhere_.size();
+}
+
+uint64_t FlatKmerIndex::numberOfKmersByPosition() const {
+	return byPos_.size();
+}
+
+uint64_t FlatKmerIndex::memoryBytes() const {
+	return byPos_.memoryBytes() + anywhere_.memoryBytes();
+}
+
+}  // namespace bibseq
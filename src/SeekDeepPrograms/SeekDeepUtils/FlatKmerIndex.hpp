@@ -0,0 +1,128 @@
+#pragma once
+/*
+ * FlatKmerIndex.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nick
+ */
+//
+// SeekDeep - A library for analyzing amplicon sequence data
+// Copyright (C) 2012-2018 Nicholas Hathaway <nicholas.hathaway@umassmed.edu>,
+// Jeffrey Bailey <Jeffrey.Bailey@umassmed.edu>
+//
+// This file is part of SeekDeep.
+//
+// SeekDeep is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// SeekDeep is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with SeekDeep.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <bibseq.h>
+
+
+namespace bibseq {
+
+/**@brief Read counts of k-mers, by position and anywhere, in flat open addressed tables of 2 bit packed k-mers
+ *
+ * Counts the same way as the KmerMaps from indexKmers, each sequence adds its cnt_ to every k-mer it has,
+ * with expandPos a k-mer is also counted at the positions up to expandSize on either side of where it occurs,
+ * k-mers with bases other than ACGT aren't counted. Once built the index is only read so threads can share it
+ *
+ * Only used by benchKmerIndex for now, the low k-mer checks are done by the aligner with its KmerMaps so this can't replace them from here
+ *
+ */
+class FlatKmerIndex {
+public:
+
+	/**@brief
+	 *
+	 * @param kLength the k-mer length, at most 24
+	 * @param expandPos whether to also count k-mers at the positions around where they occur
+	 * @param expandSize how many positions on either side to count them at
+	 */
+	FlatKmerIndex(uint32_t kLength, bool expandPos = false, uint32_t expandSize = 0);
+
+	const uint32_t kLength_;
+	const bool expandPos_;
+	const uint32_t expandSize_;
+
+	/**@brief Add a sequence's k-mers
+	 *
+	 * @param seq the sequence, at most 65535 bases
+	 * @param cnt the number of reads the sequence represents
+	 */
+	void addSeq(const std::string & seq, double cnt);
+
+	template<typename T>
+	void addSeqs(const std::vector<T> & seqs) {
+		for (const auto & seq : seqs) {
+			addSeq(seq.seqBase_.seq_, seq.seqBase_.cnt_);
+		}
+	}
+
+	/**@brief The read count of the k-mer starting at pos in seq, at that position
+	 *
+	 */
+	uint32_t countAt(const std::string & seq, uint32_t pos) const;
+
+	/**@brief The read count of the k-mer starting at pos in seq, at any position
+	 *
+	 */
+	uint32_t countAnywhere(const std::string & seq, uint32_t pos) const;
+
+	/**@brief Whether the k-mer starting at pos in seq has a read count at or below cutOff, the same test as KmerMaps::isKmerLowFrequency
+	 *
+	 * @param seq the sequence
+	 * @param pos the start of the k-mer
+	 * @param byPosition whether to use the count at the position or anywhere
+	 * @param cutOff the count to be at or below
+	 * @return true if the k-mer is low frequency, k-mers that couldn't be counted (bases other than ACGT or too close to the end) are low frequency
+	 */
+	bool isLowFrequency(const std::string & seq, uint32_t pos, bool byPosition,
+			uint32_t cutOff) const;
+
+	/**@brief Pack the k-mer starting at pos 2 bits a base
+	 *
+	 * @return false if the k-mer runs off the end of seq or has a base other than ACGT
+	 */
+	static bool packKmer(const std::string & seq, uint32_t pos, uint32_t kLength,
+			uint64_t & packed);
+
+	uint64_t numberOfKmersAnywhere() const;
+	uint64_t numberOfKmersByPosition() const;
+	uint64_t memoryBytes() const;
+
+private:
+	/**@brief Linear probing table of counts by 64 bit key, keys are stored plus one so zero marks an empty slot
+	 *
+	 */
+	class FlatCounts {
+	public:
+		FlatCounts();
+		void add(uint64_t key, uint32_t cnt);
+		uint32_t get(uint64_t key) const;
+		uint64_t size() const;
+		uint64_t memoryBytes() const;
+	private:
+		std::vector<uint64_t> keys_;
+		std::vector<uint32_t> counts_;
+		uint64_t size_{0};
+		uint64_t mask_{0};
+		void grow();
+	};
+
+	FlatCounts byPos_; /**< keyed by k-mer << 16 | position */
+	FlatCounts anywhere_;
+};
+
+}  // namespace bibseq
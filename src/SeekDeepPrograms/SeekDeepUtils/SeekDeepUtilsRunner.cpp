@@ -35,7 +35,11 @@ SeekDeepUtilsRunner::SeekDeepUtilsRunner() :
 					addFunc("setupTarAmpAnalysis", setupTarAmpAnalysis, false),
 					addFunc("replaceUnderscores", replaceUnderscores, false),
 				  addFunc("rBind", ManipulateTableRunner::rBind, false),
-					addFunc("genTargetInfoFromGenomes", genTargetInfoFromGenomes, false)}, //
+					addFunc("genTargetInfoFromGenomes", genTargetInfoFromGenomes, false),
+					addFunc("benchClusterSorting", benchClusterSorting, false),
+					addFunc("benchEditDistPrefilter", benchEditDistPrefilter, false),
+					addFunc("benchKmerIndex", benchKmerIndex, false),
+					addFunc("summarizeRunProfiles", summarizeRunProfiles, false)}, //
 				"SeekDeepUtils") {
 }
 
@@ -53,8 +57,12 @@ int SeekDeepUtilsRunner::genTargetInfoFromGenomes(const bib::progutils::CmdArgs
 	uint32_t barcodeSize = 0;
 	std::string selectedGenomesStr = "";
 	bool removeRefAlignments = false;
+	bool batchPrimers = false;
+	bool nativePrimerSearch = false;
 	setUp.processVerbose();
 	setUp.processDebug();
+	setUp.setOption(nativePrimerSearch, "--nativePrimerSearch", "Search the 2bit genomes for the primers directly instead of aligning with bowtie2, only mismatches (up to --errors) are allowed");
+	setUp.setOption(batchPrimers, "--batchPrimers", "Align all targets' primers to each genome at once instead of each target separately, genomes are aligned largest first across all threads, when there are fewer genomes than threads bowtie2's threads are split by genome size");
 	setUp.setOption(lenCutOffSizeExpand, "--lenCutOffSizeExpand", "When creating length cut off file how much to expand the length of the found targets");
 	setUp.setOption(pairedEndLength, "--pairedEndLength", "Paired End Read Length", true);
 	setUp.setOption(barcodeSize, "--barcodeSize", "Barcode Size, if on both primer, the sum of the two barcodes");
@@ -93,7 +101,8 @@ int SeekDeepUtilsRunner::genTargetInfoFromGenomes(const bib::progutils::CmdArgs
 	gMapper->pars_.numThreads_ = pars.numThreads_;
 	gMapper->init();
 	gMapper->pars_.numThreads_ = 1;
-	//set threads;
+	uint32_t totalThreads = std::max<uint32_t>(1, pars.numThreads_);
+	//set threads for the per target pathway, --batchPrimers and --nativePrimerSearch split totalThreads themselves
 	if(pars.numThreads_ >= 4){
 		gMapper->pars_.numThreads_ = 2;
 		pars.numThreads_ = pars.numThreads_/2;
@@ -129,147 +138,383 @@ int SeekDeepUtilsRunner::genTargetInfoFromGenomes(const bib::progutils::CmdArgs
 	allowableErrors.hqMismatches_ = errors;
 
 
-	auto extractPathway =
-			[&targetsQueue,&removeRefAlignments,&outputDir,&ids,&alignToGenome,&allowableErrors,&sizeLimit](
-					const std::unique_ptr<MultiGenomeMapper> & gMapper) {
-				std::string target;
-				while(targetsQueue.getVal(target)) {
-
-					const auto & primerInfo = ids.pDeterminator_->primers_.at(target);
-					auto primerDirectory = bib::files::makeDir(outputDir, bib::files::MkdirPar(primerInfo.primerPairName_));
-					auto bedDirectory = bib::files::makeDir(primerDirectory, bib::files::MkdirPar("genomeLocations"));
-					auto forwardOpts = SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectory, "forwardPrimer"));
-					auto reverseOpts = SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectory, "reversePrimer"));
-					auto forDegens = createDegenStrs(primerInfo.forwardPrimerInfo_.seq_);
-					auto revDegens = createDegenStrs(primerInfo.reversePrimerInfoForDir_.seq_);
-					//
-					std::vector<seqInfo> forSeqs;
-					if(forDegens.size() == 1){
-						forSeqs.emplace_back(primerInfo.forwardPrimerInfo_);
-					}else{
-						forSeqs = vecStrToReadObjs<seqInfo>(forDegens, primerInfo.forwardPrimerInfo_.name_);
-					}
-					std::vector<seqInfo> revSeqs;
-					if(revDegens.size() == 1){
-						revSeqs.emplace_back(primerInfo.reversePrimerInfoForDir_);
-					}else{
-						revSeqs = vecStrToReadObjs<seqInfo>(revDegens, primerInfo.reversePrimerInfoForDir_.name_);
-					}
-					SeqOutput::write(forSeqs, forwardOpts);
-					SeqOutput::write(revSeqs, reverseOpts);
-					auto refAlignmentDir = bib::files::makeDir(primerDirectory,bib::files::MkdirPar{ "refAlignments"});
-					std::vector<std::thread> threads;
-					bib::concurrent::LockableQueue<bfs::path> genomesQueue(gMapper->getGenomeFnps());
-					auto forOutFnp = forwardOpts.out_.outName();
-					auto revOutFnp = reverseOpts.out_.outName() ;
-					for(uint32_t t = 0; t < gMapper->pars_.numThreads_; ++t){
-						threads.emplace_back(std::thread(alignToGenome,
-								std::ref(genomesQueue),
-								std::cref( forOutFnp),
-								std::cref( revOutFnp),
-								std::cref(refAlignmentDir)));
-					}
-					for(auto & t : threads){
-						t.join();
-					}
-					struct GenExtracRes{
-						uint32_t forwardHits_{0};
-						uint32_t reverseHits_{0};
-						uint32_t extractCounts_{0};
-					};
-					std::unordered_map<std::string, GenExtracRes> genomeExtractionsResults;
-					for(const auto & genome : gMapper->genomes_){
-						genomeExtractionsResults[genome.first] = GenExtracRes{};
+	typedef std::vector<std::shared_ptr<AlignmentResults>> MapResults;
+
+	auto genPrimerSeqs = [&ids](const std::string & target,
+			std::vector<seqInfo> & forSeqs, std::vector<seqInfo> & revSeqs){
+		const auto & primerInfo = ids.pDeterminator_->primers_.at(target);
+		auto forDegens = createDegenStrs(primerInfo.forwardPrimerInfo_.seq_);
+		auto revDegens = createDegenStrs(primerInfo.reversePrimerInfoForDir_.seq_);
+		if(forDegens.size() == 1){
+			forSeqs.emplace_back(primerInfo.forwardPrimerInfo_);
+		}else{
+			forSeqs = vecStrToReadObjs<seqInfo>(forDegens, primerInfo.forwardPrimerInfo_.name_);
+		}
+		if(revDegens.size() == 1){
+			revSeqs.emplace_back(primerInfo.reversePrimerInfoForDir_);
+		}else{
+			revSeqs = vecStrToReadObjs<seqInfo>(revDegens, primerInfo.reversePrimerInfoForDir_.name_);
+		}
+	};
+
+	//ampliconsByGenome key is the genome name, hitCounts key is the genome name, first is the number of forward primer hits and second is the number of reverse primer hits
+	auto writeTargetAmplicons = [&ids](const std::string & target,
+			const bfs::path & primerDirectory,
+			const std::unordered_map<std::string, std::vector<TwoBitPrimerSearcher::Amplicon>> & ampliconsByGenome,
+			const std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> & hitCounts,
+			const std::unique_ptr<MultiGenomeMapper> & gMapper){
+		const auto & primerInfo = ids.pDeterminator_->primers_.at(target);
+		auto bedDirectory = bib::files::makeDir(primerDirectory, bib::files::MkdirPar("genomeLocations"));
+		struct GenExtracRes{
+			uint32_t forwardHits_{0};
+			uint32_t reverseHits_{0};
+			uint32_t extractCounts_{0};
+		};
+		std::unordered_map<std::string, GenExtracRes> genomeExtractionsResults;
+		for(const auto & genome : gMapper->genomes_){
+			genomeExtractionsResults[genome.first] = GenExtracRes{};
+		}
+		for(const auto & genomeCounts : hitCounts){
+			genomeExtractionsResults[genomeCounts.first].forwardHits_ = genomeCounts.second.first;
+			genomeExtractionsResults[genomeCounts.first].reverseHits_ = genomeCounts.second.second;
+		}
+		std::vector<seqInfo> refSeqs;
+		std::vector<seqInfo> refTrimmedSeqs;
+		for(const auto & genome : ampliconsByGenome){
+			genomeExtractionsResults[genome.first].extractCounts_ = genome.second.size();
+			OutputStream bedOut{OutOptions(bib::files::make_path(bedDirectory, genome.first + ".bed"))};
+			uint32_t extractionCount = 0;
+			for(const auto & extract : genome.second){
+				auto bedRegion = extract.region_.genBedRecordCore();
+				bedRegion.name_ = genome.first + "-" + target;
+				bedOut << bedRegion.toDelimStr() << std::endl;
+				auto name = genome.first;
+				if(0 != extractionCount){
+					name.append("." + estd::to_string(extractionCount));
+				}
+				TwoBit::TwoBitFile tReader(gMapper->genomes_.at(genome.first)->fnpTwoBit_);
+				auto eSeq = extract.region_.extractSeq(tReader);
+				eSeq.name_ = name;
+
+				bool refFound = false;
+				for(auto & rSeq : refSeqs){
+					if(rSeq.seq_ == eSeq.seq_){
+						refFound = true;
+						rSeq.name_.append("-" + eSeq.name_);
 					}
-					std::unordered_map<std::string, std::vector<GenomeExtractResult>> genomeExtracts;
-					for(const auto & genome : gMapper->genomes_) {
-						auto forBamFnp = bib::files::make_path(refAlignmentDir,
-								bfs::basename(genome.second->fnp_) + "_" + bfs::basename(forwardOpts.out_.outName()) + ".sorted.bam");
-						auto revBamFnp = bib::files::make_path(refAlignmentDir,
-														bfs::basename(genome.second->fnp_) + "_" + bfs::basename(reverseOpts.out_.outName()) + ".sorted.bam");
-						auto forResults = gatherMapResults(forBamFnp, genome.second->fnpTwoBit_, allowableErrors);
-						auto revResults = gatherMapResults(revBamFnp, genome.second->fnpTwoBit_, allowableErrors);
-						genomeExtractionsResults[genome.first].forwardHits_ = forResults.size();
-						genomeExtractionsResults[genome.first].reverseHits_ = revResults.size();
-						if(!forResults.empty() && !revResults.empty()){
-							auto uniForRes = getUniqueLocationResults(forResults);
-							auto uniRevRes = getUniqueLocationResults(revResults);
-							genomeExtracts[genome.first] = getPossibleGenomeExtracts(uniForRes, uniRevRes, sizeLimit);
-						}
+				}
+				if(!refFound){
+					refSeqs.emplace_back(eSeq);
+				}
+				bool trimmed_refFound = false;
+
+				auto innerSeq = extract.innerRegion_.extractSeq(tReader);
+				innerSeq.name_ = name;
+				for(auto & rSeq : refTrimmedSeqs){
+					if(rSeq.seq_ == innerSeq.seq_){
+						trimmed_refFound = true;
+						rSeq.name_.append("-" + innerSeq.name_);
 					}
-					std::vector<seqInfo> refSeqs;
-					std::vector<seqInfo> refTrimmedSeqs;
-					for( auto & genome : genomeExtracts){
-						genomeExtractionsResults[genome.first].extractCounts_ = genome.second.size();
-						OutputStream bedOut{OutOptions(bib::files::make_path(bedDirectory, genome.first + ".bed"))};
-						uint32_t extractionCount = 0;
-						for(auto & extract : genome.second){
-							extract.setRegion();
-							auto bedRegion = extract.gRegion_->genBedRecordCore();
-							bedRegion.name_ = genome.first + "-" + target;
-							bedOut << bedRegion.toDelimStr() << std::endl;
-							auto name = genome.first;
-							if(0 != extractionCount){
-								name.append("." + estd::to_string(extractionCount));
-							}
-							TwoBit::TwoBitFile tReader(gMapper->genomes_.at(genome.first)->fnpTwoBit_);
-							auto eSeq = extract.gRegion_->extractSeq(tReader);
-							eSeq.name_ = name;
-
-							bool refFound = false;
-							for(auto & rSeq : refSeqs){
-								if(rSeq.seq_ == eSeq.seq_){
-									refFound = true;
-									rSeq.name_.append("-" + eSeq.name_);
-								}
-							}
-							if(!refFound){
-								refSeqs.emplace_back(eSeq);
-							}
-							bool trimmed_refFound = false;
-
-							auto innerSeq = extract.gRegionInner_->extractSeq(tReader);
-							innerSeq.name_ = name;
-							for(auto & rSeq : refTrimmedSeqs){
-								if(rSeq.seq_ == innerSeq.seq_){
-									trimmed_refFound = true;
-									rSeq.name_.append("-" + innerSeq.name_);
-								}
-							}
-							if(!trimmed_refFound){
-								refTrimmedSeqs.emplace_back(innerSeq);
+				}
+				if(!trimmed_refFound){
+					refTrimmedSeqs.emplace_back(innerSeq);
+				}
+				++extractionCount;
+			}
+		}
+		auto fullSeqOpts = SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectory, primerInfo.primerPairName_ +".fasta"));
+		auto innerSeqOpts = SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectory, primerInfo.primerPairName_ +"_primersRemoved.fasta"));
+		SeqOutput::write(refSeqs, fullSeqOpts);
+		SeqOutput::write(refTrimmedSeqs, innerSeqOpts);
+		table performanceTab(VecStr{"genome", "forwardPrimerHits", "reversePrimerHits", "extractionCounts"});
+		auto genomeKeys = getVectorOfMapKeys(genomeExtractionsResults);
+		bib::sort(genomeKeys);
+		for(const auto & genomeKey : genomeKeys){
+			performanceTab.addRow(genomeKey,
+					genomeExtractionsResults[genomeKey].forwardHits_,
+					genomeExtractionsResults[genomeKey].reverseHits_,
+					genomeExtractionsResults[genomeKey].extractCounts_);
+		}
+		auto perTabOpts = TableIOOpts::genTabFileOut(bib::files::make_path(primerDirectory, "extractionCounts"),true);
+		performanceTab.outPutContents(perTabOpts);
+	};
+
+	//resultsByGenome, key is the genome name, first is the forward primer hits and second is the reverse primer hits
+	auto writeTargetExtractions = [&sizeLimit,&writeTargetAmplicons](const std::string & target,
+			const bfs::path & primerDirectory,
+			const std::unordered_map<std::string, std::pair<MapResults, MapResults>> & resultsByGenome,
+			const std::unique_ptr<MultiGenomeMapper> & gMapper){
+		std::unordered_map<std::string, std::vector<TwoBitPrimerSearcher::Amplicon>> ampliconsByGenome;
+		std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> hitCounts;
+		for(const auto & genomeResults : resultsByGenome) {
+			auto forResults = genomeResults.second.first;
+			auto revResults = genomeResults.second.second;
+			hitCounts[genomeResults.first] = std::make_pair(forResults.size(), revResults.size());
+			if(!forResults.empty() && !revResults.empty()){
+				auto uniForRes = getUniqueLocationResults(forResults);
+				auto uniRevRes = getUniqueLocationResults(revResults);
+				auto extracts = getPossibleGenomeExtracts(uniForRes, uniRevRes, sizeLimit);
+				auto & amplicons = ampliconsByGenome[genomeResults.first];
+				for(auto & extract : extracts){
+					extract.setRegion();
+					amplicons.emplace_back(*extract.gRegion_, *extract.gRegionInner_);
+				}
+			}
+		}
+		writeTargetAmplicons(target, primerDirectory, ampliconsByGenome, hitCounts, gMapper);
+	};
+
+	if (nativePrimerSearch) {
+		//search the 2bit genomes directly, each genome is read once for all targets' primers
+		std::vector<TwoBitPrimerSearcher::Primer> allPrimers;
+		std::map<std::string, bfs::path> primerDirectories;
+		for (const auto & target : ids.getTargets()) {
+			const auto & primerInfo = ids.pDeterminator_->primers_.at(target);
+			primerDirectories[target] = bib::files::makeDir(outputDir, bib::files::MkdirPar(primerInfo.primerPairName_));
+			std::vector<seqInfo> forSeqs;
+			std::vector<seqInfo> revSeqs;
+			genPrimerSeqs(target, forSeqs, revSeqs);
+			SeqOutput::write(forSeqs, SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectories[target], "forwardPrimer")));
+			SeqOutput::write(revSeqs, SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectories[target], "reversePrimer")));
+			for (const auto & seq : forSeqs) {
+				allPrimers.emplace_back(target, true, seq.seq_);
+			}
+			for (const auto & seq : revSeqs) {
+				allPrimers.emplace_back(target, false, seq.seq_);
+			}
+		}
+		TwoBitPrimerSearcher searcher(allPrimers, errors);
+		auto genomeNames = getVectorOfMapKeys(gMapper->genomes_);
+		bib::sort(genomeNames);
+		std::unordered_map<std::string, std::vector<TwoBitPrimerSearcher::Hit>> hitsByGenome;
+		for (const auto & genomeName : genomeNames) {
+			if (setUp.pars_.verbose_) {
+				std::cout << "Searching " << genomeName << std::endl;
+			}
+			hitsByGenome[genomeName] = searcher.searchGenome(
+					gMapper->genomes_.at(genomeName)->fnpTwoBit_, totalThreads);
+		}
+		bib::concurrent::LockableQueue<std::string> nativeTargetsQueue(ids.getTargets());
+		auto extractTargets = [&](){
+			std::string target;
+			while(nativeTargetsQueue.getVal(target)) {
+				std::unordered_map<std::string, std::vector<TwoBitPrimerSearcher::Amplicon>> ampliconsByGenome;
+				std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> hitCounts;
+				for (const auto & genomeHits : hitsByGenome) {
+					uint32_t forwardHits = 0;
+					uint32_t reverseHits = 0;
+					for (const auto & hit : genomeHits.second) {
+						const auto & primer = searcher.primers_[hit.primerPos_];
+						if (primer.target_ == target) {
+							if (primer.forward_) {
+								++forwardHits;
+							} else {
+								++reverseHits;
 							}
-							++extractionCount;
 						}
 					}
-					auto fullSeqOpts = SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectory, primerInfo.primerPairName_ +".fasta"));
-					auto innerSeqOpts = SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectory, primerInfo.primerPairName_ +"_primersRemoved.fasta"));
-					SeqOutput::write(refSeqs, fullSeqOpts);
-					SeqOutput::write(refTrimmedSeqs, innerSeqOpts);
-					table performanceTab(VecStr{"genome", "forwardPrimerHits", "reversePrimerHits", "extractionCounts"});
-					auto genomeKeys = getVectorOfMapKeys(genomeExtractionsResults);
-					bib::sort(genomeKeys);
-					for(const auto & genomeKey : genomeKeys){
-						performanceTab.addRow(genomeKey,
-								genomeExtractionsResults[genomeKey].forwardHits_,
-								genomeExtractionsResults[genomeKey].reverseHits_,
-								genomeExtractionsResults[genomeKey].extractCounts_);
-					}
-					auto perTabOpts = TableIOOpts::genTabFileOut(bib::files::make_path(primerDirectory, "extractionCounts"),true);
-					performanceTab.outPutContents(perTabOpts);
-					if(removeRefAlignments){
-						bib::files::rmDirForce(refAlignmentDir);
+					hitCounts[genomeHits.first] = std::make_pair(forwardHits, reverseHits);
+					if (forwardHits > 0 && reverseHits > 0) {
+						ampliconsByGenome[genomeHits.first] = searcher.genAmplicons(
+								genomeHits.second, target, genomeHits.first + "-" + target,
+								sizeLimit);
 					}
+				}
+				writeTargetAmplicons(target, primerDirectories.at(target),
+						ampliconsByGenome, hitCounts, gMapper);
+			}
+		};
+		std::vector<std::thread> threads;
+		for(uint32_t t = 0; t < totalThreads; ++t){
+			threads.emplace_back(std::thread(extractTargets));
+		}
+		for(auto & t : threads){
+			t.join();
+		}
+	} else if (batchPrimers) {
+		//all targets' primers go into one fasta so each genome only has to be aligned against once,
+		//genomes are aligned largest first over a pool of all the threads instead of a fixed split between targets and genomes
+		std::vector<seqInfo> allPrimers;
+		std::unordered_map<std::string, std::pair<std::string, bool>> primerNameToTarget;
+		std::map<std::string, bfs::path> primerDirectories;
+		for (const auto & target : ids.getTargets()) {
+			const auto & primerInfo = ids.pDeterminator_->primers_.at(target);
+			primerDirectories[target] = bib::files::makeDir(outputDir, bib::files::MkdirPar(primerInfo.primerPairName_));
+			std::vector<seqInfo> forSeqs;
+			std::vector<seqInfo> revSeqs;
+			genPrimerSeqs(target, forSeqs, revSeqs);
+			SeqOutput::write(forSeqs, SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectories[target], "forwardPrimer")));
+			SeqOutput::write(revSeqs, SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectories[target], "reversePrimer")));
+			for (const auto pos : iter::range(forSeqs.size())) {
+				auto primer = forSeqs[pos];
+				primer.name_ = target + ".forward." + estd::to_string(pos);
+				primerNameToTarget[primer.name_] = std::make_pair(target, true);
+				allPrimers.emplace_back(primer);
+			}
+			for (const auto pos : iter::range(revSeqs.size())) {
+				auto primer = revSeqs[pos];
+				primer.name_ = target + ".reverse." + estd::to_string(pos);
+				primerNameToTarget[primer.name_] = std::make_pair(target, false);
+				allPrimers.emplace_back(primer);
+			}
+		}
+		auto refAlignmentDir = bib::files::makeDir(outputDir, bib::files::MkdirPar{ "refAlignments"});
+		auto allPrimersOpts = SeqIOOptions::genFastaOut(bib::files::make_path(refAlignmentDir, "allPrimers"));
+		SeqOutput::write(allPrimers, allPrimersOpts);
+		auto allPrimersFnp = allPrimersOpts.out_.outName();
+
+		auto genomeFnps = gMapper->getGenomeFnps();
+		std::stable_sort(genomeFnps.begin(), genomeFnps.end(),
+				[](const bfs::path & fnp1, const bfs::path & fnp2) {
+					return bfs::file_size(fnp1) > bfs::file_size(fnp2);
+				});
+		std::unordered_map<std::string, std::string> genomeFnpToName;
+		for (const auto & genome : gMapper->genomes_) {
+			genomeFnpToName[genome.second->fnp_.string()] = genome.first;
+		}
+		uint32_t genomeWorkers = std::max<uint32_t>(1,
+				std::min<uint32_t>(totalThreads, genomeFnps.size()));
+		//with fewer genomes than threads they are all aligned at once and the threads are split by genome size so the largest don't finish last,
+		//otherwise each genome gets one thread and the workers take the next largest genome as they finish
+		std::unordered_map<std::string, uint32_t> bowtie2Threads;
+		for (const auto & genomeFnp : genomeFnps) {
+			bowtie2Threads[genomeFnp.string()] = 1;
+		}
+		if (!genomeFnps.empty() && genomeFnps.size() < totalThreads) {
+			uintmax_t totalGenomeSize = 0;
+			for (const auto & genomeFnp : genomeFnps) {
+				totalGenomeSize += bfs::file_size(genomeFnp);
+			}
+			uint32_t extraThreads = totalThreads - genomeFnps.size();
+			uint32_t assignedThreads = genomeFnps.size();
+			if (totalGenomeSize > 0) {
+				for (const auto & genomeFnp : genomeFnps) {
+					auto genomeExtra = static_cast<uint32_t>(extraThreads * bfs::file_size(genomeFnp) / totalGenomeSize);
+					bowtie2Threads[genomeFnp.string()] += genomeExtra;
+					assignedThreads += genomeExtra;
+				}
+			}
+			//rounding down leaves threads over, they go to the largest genomes first
+			for (uint32_t genomePos = 0; assignedThreads < totalThreads; ++assignedThreads) {
+				++bowtie2Threads[genomeFnps[genomePos].string()];
+				genomePos = (genomePos + 1) % genomeFnps.size();
+			}
+		}
 
+		//key1 = target, key2 = genome
+		std::map<std::string, std::unordered_map<std::string, std::pair<MapResults, MapResults>>> resultsByTarget;
+		std::mutex resultsMut;
+		bib::concurrent::LockableQueue<bfs::path> genomesQueue(genomeFnps);
+		auto alignAllPrimers = [&](){
+			bfs::path genomeFnp = "";
+			while(genomesQueue.getVal(genomeFnp)){
+				const auto & genomeName = genomeFnpToName.at(genomeFnp.string());
+				BioCmdsUtils bioRunner;
+				auto seqOpts = SeqIOOptions::genFastaIn(allPrimersFnp, false);
+				seqOpts.out_.outFilename_ = bib::files::make_path(refAlignmentDir, bfs::basename(genomeFnp) + "_allPrimers.sorted.bam");
+				bioRunner.bowtie2Align(seqOpts, genomeFnp,
+						"-D 20 -R 3 -N 1 -L 15 -i S,1,0.5 -a --end-to-end -p " + estd::to_string(bowtie2Threads.at(genomeFnp.string())));
+				auto results = gatherMapResults(seqOpts.out_.outFilename_, gMapper->genomes_.at(genomeName)->fnpTwoBit_, allowableErrors);
+				std::lock_guard<std::mutex> lock(resultsMut);
+				for (const auto & result : results) {
+					const auto & primerTarget = primerNameToTarget.at(result->bAln_.Name);
+					auto & genomeResults = resultsByTarget[primerTarget.first][genomeName];
+					if (primerTarget.second) {
+						genomeResults.first.emplace_back(result);
+					} else {
+						genomeResults.second.emplace_back(result);
+					}
 				}
-			};
-	std::vector<std::thread> threads;
-	for(uint32_t t = 0; t < pars.numThreads_; ++t){
-		threads.emplace_back(std::thread(extractPathway,
-				std::cref(gMapper)));
-	}
-	for(auto & t : threads){
-		t.join();
+			}
+		};
+		{
+			std::vector<std::thread> threads;
+			for(uint32_t t = 0; t < genomeWorkers; ++t){
+				threads.emplace_back(std::thread(alignAllPrimers));
+			}
+			for(auto & t : threads){
+				t.join();
+			}
+		}
+		//extractions are independent per target so they get the whole pool too
+		bib::concurrent::LockableQueue<std::string> batchTargetsQueue(ids.getTargets());
+		auto extractTargets = [&](){
+			std::string target;
+			while(batchTargetsQueue.getVal(target)) {
+				writeTargetExtractions(target, primerDirectories.at(target),
+						resultsByTarget.at(target), gMapper);
+			}
+		};
+		//make sure every target has an entry before the threads start reading
+		for (const auto & target : ids.getTargets()) {
+			resultsByTarget[target];
+		}
+		{
+			std::vector<std::thread> threads;
+			for(uint32_t t = 0; t < totalThreads; ++t){
+				threads.emplace_back(std::thread(extractTargets));
+			}
+			for(auto & t : threads){
+				t.join();
+			}
+		}
+		if(removeRefAlignments){
+			bib::files::rmDirForce(refAlignmentDir);
+		}
+	} else {
+		auto extractPathway =
+				[&targetsQueue,&removeRefAlignments,&outputDir,&ids,&alignToGenome,&allowableErrors,&genPrimerSeqs,&writeTargetExtractions](
+						const std::unique_ptr<MultiGenomeMapper> & gMapper) {
+					std::string target;
+					while(targetsQueue.getVal(target)) {
+						const auto & primerInfo = ids.pDeterminator_->primers_.at(target);
+						auto primerDirectory = bib::files::makeDir(outputDir, bib::files::MkdirPar(primerInfo.primerPairName_));
+						auto forwardOpts = SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectory, "forwardPrimer"));
+						auto reverseOpts = SeqIOOptions::genFastaOut(bib::files::make_path(primerDirectory, "reversePrimer"));
+						std::vector<seqInfo> forSeqs;
+						std::vector<seqInfo> revSeqs;
+						genPrimerSeqs(target, forSeqs, revSeqs);
+						SeqOutput::write(forSeqs, forwardOpts);
+						SeqOutput::write(revSeqs, reverseOpts);
+						auto refAlignmentDir = bib::files::makeDir(primerDirectory,bib::files::MkdirPar{ "refAlignments"});
+						std::vector<std::thread> threads;
+						bib::concurrent::LockableQueue<bfs::path> genomesQueue(gMapper->getGenomeFnps());
+						auto forOutFnp = forwardOpts.out_.outName();
+						auto revOutFnp = reverseOpts.out_.outName() ;
+						for(uint32_t t = 0; t < gMapper->pars_.numThreads_; ++t){
+							threads.emplace_back(std::thread(alignToGenome,
+									std::ref(genomesQueue),
+									std::cref( forOutFnp),
+									std::cref( revOutFnp),
+									std::cref(refAlignmentDir)));
+						}
+						for(auto & t : threads){
+							t.join();
+						}
+						std::unordered_map<std::string, std::pair<MapResults, MapResults>> resultsByGenome;
+						for(const auto & genome : gMapper->genomes_) {
+							auto forBamFnp = bib::files::make_path(refAlignmentDir,
+									bfs::basename(genome.second->fnp_) + "_" + bfs::basename(forwardOpts.out_.outName()) + ".sorted.bam");
+							auto revBamFnp = bib::files::make_path(refAlignmentDir,
+															bfs::basename(genome.second->fnp_) + "_" + bfs::basename(reverseOpts.out_.outName()) + ".sorted.bam");
+							resultsByGenome[genome.first] = std::make_pair(
+									gatherMapResults(forBamFnp, genome.second->fnpTwoBit_, allowableErrors),
+									gatherMapResults(revBamFnp, genome.second->fnpTwoBit_, allowableErrors));
+						}
+						writeTargetExtractions(target, primerDirectory, resultsByGenome, gMapper);
+						if(removeRefAlignments){
+							bib::files::rmDirForce(refAlignmentDir);
+						}
+					}
+				};
+		std::vector<std::thread> threads;
+		for(uint32_t t = 0; t < pars.numThreads_; ++t){
+			threads.emplace_back(std::thread(extractPathway,
+					std::cref(gMapper)));
+		}
+		for(auto & t : threads){
+			t.join();
+		}
 	}
 	auto forSeekDeepDir = bib::files::make_path(setUp.pars_.directoryName_, "forSeekDeep");
 	bib::files::makeDir(bib::files::MkdirPar{forSeekDeepDir});
@@ -333,6 +578,370 @@ int SeekDeepUtilsRunner::genTargetInfoFromGenomes(const bib::progutils::CmdArgs
 }
 
 
+int SeekDeepUtilsRunner::benchClusterSorting(
+		const bib::progutils::CmdArgs & inputCommands) {
+	uint32_t numClusters = 100000;
+	uint32_t seqLength = 250;
+	uint32_t rounds = 10;
+	double changeFrac = 0.01;
+	uint32_t seed = 42;
+	seqSetUp setUp(inputCommands);
+	setUp.processVerbose();
+	setUp.setOption(numClusters, "--numClusters", "Number of random clusters to sort");
+	setUp.setOption(seqLength, "--seqLength", "Length of the random cluster sequences");
+	setUp.setOption(rounds, "--rounds", "Number of rounds of count changes followed by a re-sort");
+	setUp.setOption(changeFrac, "--changeFrac", "Fraction of the clusters whose counts change each round");
+	setUp.setOption(seed, "--seed", "Seed for the random clusters");
+	if (0 == numClusters || 0 == rounds) {
+		setUp.failed_ = true;
+		setUp.addWarning("--numClusters and --rounds have to be greater than 0");
+	}
+	setUp.finishSetUp(std::cout);
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<uint32_t> baseDist(0, 3);
+	std::uniform_int_distribution<uint32_t> qualDist(10, 40);
+	//counts are skewed towards low counts like real amplicon data
+	std::geometric_distribution<uint32_t> cntDist(0.3);
+	const std::string bases = "ACGT";
+	std::vector<cluster> clusters;
+	clusters.reserve(numClusters);
+	for (const auto clusNum : iter::range(numClusters)) {
+		std::string seq(seqLength, 'A');
+		std::vector<uint32_t> qual(seqLength);
+		for (const auto pos : iter::range(seqLength)) {
+			seq[pos] = bases[baseDist(gen)];
+			qual[pos] = qualDist(gen);
+		}
+		clusters.emplace_back(seqInfo("clus." + estd::to_string(clusNum), seq, qual,
+				1 + cntDist(gen)));
+	}
+	clusterVec::allSetFractionClusters(clusters);
+
+	auto timeIt = [](const std::function<void()> & func){
+		auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+	table benchTab(VecStr{"method", "clusters", "seconds"});
+	//full sorts, moving the clusters while sorting vs sorting positions and moving each cluster once
+	{
+		auto clustersCopy = clusters;
+		auto secs = timeIt([&clustersCopy]() {
+			readVecSorter::sortReadVector(clustersCopy, "totalCount");
+			readVecSorter::sort(clustersCopy);
+		});
+		benchTab.addRow("sortClusters", clustersCopy.size(), secs);
+	}
+	{
+		auto clustersCopy = clusters;
+		auto secs = timeIt([&clustersCopy]() {
+			ClusterSortOrder::sortByTotalCount(clustersCopy);
+		});
+		benchTab.addRow("sortPositions", clustersCopy.size(), secs);
+	}
+	//re-sorting after a few counts change each round, re-sorting every position vs moving only the changed positions
+	std::uniform_int_distribution<uint32_t> posDist(0, numClusters - 1);
+	uint32_t changesPerRound = std::max<uint32_t>(1, numClusters * changeFrac);
+	std::vector<std::vector<std::pair<uint32_t, double>>> changes(rounds);
+	for (auto & round : changes) {
+		for (uint32_t change = 0; change < changesPerRound; ++change) {
+			auto pos = posDist(gen);
+			round.emplace_back(pos, clusters[pos].seqBase_.cnt_ + 1 + cntDist(gen));
+		}
+	}
+	std::vector<double> counts;
+	for (const auto & clus : clusters) {
+		counts.emplace_back(clus.seqBase_.cnt_);
+	}
+	std::vector<uint32_t> resortedOrder;
+	{
+		auto countsCopy = counts;
+		auto secs = timeIt([&countsCopy,&changes,&resortedOrder]() {
+			resortedOrder.resize(countsCopy.size());
+			std::iota(resortedOrder.begin(), resortedOrder.end(), 0);
+			for (const auto & round : changes) {
+				for (const auto & change : round) {
+					countsCopy[change.first] = change.second;
+				}
+				std::sort(resortedOrder.begin(), resortedOrder.end(),
+						[&countsCopy](uint32_t pos1, uint32_t pos2) {
+							return countsCopy[pos1] == countsCopy[pos2] ?
+									pos1 < pos2 : countsCopy[pos1] > countsCopy[pos2];
+						});
+			}
+		});
+		benchTab.addRow("resortPositions", countsCopy.size(), secs);
+	}
+	std::vector<uint32_t> incrementalOrder;
+	{
+		auto secs = timeIt([&counts,&changes,&incrementalOrder]() {
+			IncrementalCountOrder countOrder(counts);
+			for (const auto & round : changes) {
+				for (const auto & change : round) {
+					countOrder.setCount(change.first, change.second);
+				}
+				countOrder.getOrder();
+			}
+			incrementalOrder = countOrder.getOrder();
+		});
+		benchTab.addRow("incrementalOrder", counts.size(), secs);
+	}
+	if (incrementalOrder != resortedOrder) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error incremental order doesn't match the re-sorted order" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	benchTab.outPutContentOrganized(std::cout);
+	return 0;
+}
+
+int SeekDeepUtilsRunner::benchEditDistPrefilter(
+		const bib::progutils::CmdArgs & inputCommands) {
+	uint32_t maxPairs = 100000;
+	uint32_t maxEdits = 2;
+	seqSetUp setUp(inputCommands);
+	setUp.processVerbose();
+	setUp.processDefaultReader(true);
+	setUp.processAlignerDefualts();
+	setUp.setOption(maxPairs, "--maxPairs", "Maximum number of pairs of unique sequences to compare");
+	setUp.setOption(maxEdits, "--maxEdits", "Report how many pairs have an edit distance above this, the pairs the prefilter would skip");
+	setUp.finishSetUp(std::cout);
+
+	//compare unique sequences, like the clusters qluster compares
+	std::vector<seqInfo> seqs;
+	std::unordered_set<std::string> seenSeqs;
+	uint64_t maxSize = 0;
+	{
+		SeqInput reader(setUp.pars_.ioOptions_);
+		reader.openIn();
+		seqInfo seq;
+		while (reader.readNextRead(seq)) {
+			if (seenSeqs.emplace(seq.seq_).second) {
+				readVec::getMaxLength(seq, maxSize);
+				seqs.emplace_back(seq);
+			}
+		}
+	}
+	std::vector<std::pair<uint32_t, uint32_t>> pairs;
+	for (uint32_t pos1 = 0; pos1 < seqs.size() && pairs.size() < maxPairs; ++pos1) {
+		for (uint32_t pos2 = 0; pos2 < pos1 && pairs.size() < maxPairs; ++pos2) {
+			pairs.emplace_back(pos1, pos2);
+		}
+	}
+	aligner alignerObj(maxSize, setUp.pars_.gapInfo_, setUp.pars_.scoring_,
+			KmerMaps(setUp.pars_.colOpts_.kmerOpts_.kLength_),
+			setUp.pars_.qScorePars_, true, false);
+
+	auto timeIt = [](const std::function<void()> & func){
+		auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+	//the aligned columns that differ, i.e. the mismatches plus indel bases of the aligner's alignment
+	std::vector<uint32_t> alignmentEdits;
+	alignmentEdits.reserve(pairs.size());
+	auto alnSecs = timeIt([&pairs,&seqs,&alignerObj,&alignmentEdits]() {
+		for (const auto & pair : pairs) {
+			alignerObj.alignRegGlobal(seqs[pair.first], seqs[pair.second]);
+			const auto & alnSeqA = alignerObj.alignObjectA_.seqBase_.seq_;
+			const auto & alnSeqB = alignerObj.alignObjectB_.seqBase_.seq_;
+			uint32_t edits = 0;
+			for (const auto pos : iter::range(alnSeqA.size())) {
+				if (alnSeqA[pos] != alnSeqB[pos]) {
+					++edits;
+				}
+			}
+			alignmentEdits.emplace_back(edits);
+		}
+	});
+	std::vector<uint32_t> distances;
+	distances.reserve(pairs.size());
+	auto editSecs = timeIt([&pairs,&seqs,&distances]() {
+		//the prefilter builds the pattern once per cluster so only the distances are timed per pair
+		std::vector<std::unique_ptr<BitParallelEditDistance>> patterns;
+		for (const auto & seq : seqs) {
+			patterns.emplace_back(std::make_unique<BitParallelEditDistance>(seq.seq_));
+		}
+		for (const auto & pair : pairs) {
+			distances.emplace_back(patterns[pair.second]->distance(seqs[pair.first].seq_));
+		}
+	});
+	uint32_t overBound = 0;
+	uint32_t skippable = 0;
+	for (const auto pos : iter::range(pairs.size())) {
+		if (distances[pos] > alignmentEdits[pos]) {
+			++overBound;
+		}
+		if (distances[pos] > maxEdits) {
+			++skippable;
+		}
+	}
+	table benchTab(VecStr{"method", "pairs", "seconds", "pairsPerSecond"});
+	benchTab.addRow("alignRegGlobal", pairs.size(), alnSecs,
+			alnSecs > 0 ? pairs.size() / alnSecs : 0);
+	benchTab.addRow("bitParallelEditDistance", pairs.size(), editSecs,
+			editSecs > 0 ? pairs.size() / editSecs : 0);
+	benchTab.outPutContentOrganized(std::cout);
+	std::cout << "Unique sequences: " << seqs.size() << std::endl;
+	std::cout << "Pairs with edit distance above " << maxEdits << ": "
+			<< getPercentageString(skippable, pairs.size()) << std::endl;
+	if (overBound > 0) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error edit distance was more than the aligner's mismatches and indel bases for "
+				<< overBound << " pairs" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	return 0;
+}
+
+int SeekDeepUtilsRunner::benchKmerIndex(
+		const bib::progutils::CmdArgs & inputCommands) {
+	uint32_t rounds = 3;
+	seqSetUp setUp(inputCommands);
+	setUp.processVerbose();
+	setUp.processDefaultReader(true);
+	setUp.processAlignerDefualts();
+	setUp.setOption(rounds, "--rounds", "Number of times to look up every k-mer of every unique sequence");
+	if (0 == rounds) {
+		setUp.failed_ = true;
+		setUp.addWarning("--rounds has to be greater than 0");
+	}
+	setUp.finishSetUp(std::cout);
+
+	//index the unique sequences, like qluster does
+	SeqInput reader(setUp.pars_.ioOptions_);
+	auto reads = reader.readAllReads<readObject>();
+	auto identicalClusters = clusterCollapser::collapseIdenticalReads(reads, "median");
+	std::vector<cluster> clusters;
+	clusters.reserve(identicalClusters.size());
+	for (const auto & read : identicalClusters) {
+		clusters.emplace_back(read.seqBase_);
+	}
+	processRunCutoff(setUp.pars_.colOpts_.kmerOpts_.runCutOff_,
+			setUp.pars_.colOpts_.kmerOpts_.runCutOffString_,
+			readVec::getTotalReadCount(reads));
+	const auto & kmerOpts = setUp.pars_.colOpts_.kmerOpts_;
+
+	auto timeIt = [](const std::function<void()> & func){
+		auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+	//the flat index is built first so the peak memory increase of each build can be told apart
+	FlatKmerIndex flatIndex(kmerOpts.kLength_, setUp.pars_.expandKmerPos_, setUp.pars_.expandKmerSize_);
+	auto flatStart = RunPhaseProfiler::Usage::current();
+	auto flatBuildSecs = timeIt([&flatIndex,&clusters]() {
+		flatIndex.addSeqs(clusters);
+	});
+	auto flatEnd = RunPhaseProfiler::Usage::current();
+	KmerMaps kMaps;
+	auto mapsBuildSecs = timeIt([&kMaps,&clusters,&kmerOpts,&setUp]() {
+		kMaps = indexKmers(clusters, kmerOpts.kLength_, kmerOpts.runCutOff_,
+				kmerOpts.kmersByPosition_, setUp.pars_.expandKmerPos_, setUp.pars_.expandKmerSize_);
+	});
+	auto mapsEnd = RunPhaseProfiler::Usage::current();
+
+	uint64_t lookups = 0;
+	uint64_t mapsLow = 0;
+	uint64_t flatLow = 0;
+	uint64_t disagree = 0;
+	std::vector<bool> mapsResults;
+	auto mapsLookupSecs = timeIt([&]() {
+		for (uint32_t round = 0; round < rounds; ++round) {
+			for (const auto & clus : clusters) {
+				const auto & seq = clus.seqBase_.seq_;
+				for (uint32_t pos = 0; pos + kmerOpts.kLength_ <= seq.size(); ++pos) {
+					bool low = kMaps.isKmerLowFrequency(seq.substr(pos, kmerOpts.kLength_),
+							pos, kmerOpts.kmersByPosition_, kmerOpts.runCutOff_);
+					if (0 == round) {
+						mapsResults.push_back(low);
+						mapsLow += low;
+					}
+				}
+			}
+		}
+	});
+	auto flatLookupSecs = timeIt([&]() {
+		uint64_t resultPos = 0;
+		for (uint32_t round = 0; round < rounds; ++round) {
+			for (const auto & clus : clusters) {
+				const auto & seq = clus.seqBase_.seq_;
+				for (uint32_t pos = 0; pos + kmerOpts.kLength_ <= seq.size(); ++pos) {
+					bool low = flatIndex.isLowFrequency(seq, pos,
+							kmerOpts.kmersByPosition_, kmerOpts.runCutOff_);
+					if (0 == round) {
+						flatLow += low;
+						++lookups;
+						if (low != mapsResults[resultPos]) {
+							++disagree;
+						}
+						++resultPos;
+					}
+				}
+			}
+		}
+	});
+	table benchTab(VecStr{"index", "buildSeconds", "peakRssIncreaseKb", "lookups", "lookupSeconds", "lowFrequency"});
+	benchTab.addRow("KmerMaps", mapsBuildSecs, mapsEnd.peakRssKb_ - flatEnd.peakRssKb_,
+			lookups * rounds, mapsLookupSecs, mapsLow);
+	benchTab.addRow("FlatKmerIndex", flatBuildSecs, flatEnd.peakRssKb_ - flatStart.peakRssKb_,
+			lookups * rounds, flatLookupSecs, flatLow);
+	benchTab.outPutContentOrganized(std::cout);
+	std::cout << "Unique sequences: " << clusters.size() << std::endl;
+	std::cout << "FlatKmerIndex k-mers by position: " << flatIndex.numberOfKmersByPosition()
+			<< ", anywhere: " << flatIndex.numberOfKmersAnywhere()
+			<< ", table bytes: " << flatIndex.memoryBytes() << std::endl;
+	if (disagree > 0) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error FlatKmerIndex and KmerMaps disagreed on whether "
+				<< disagree << " k-mers were low frequency" << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	return 0;
+}
+
+int SeekDeepUtilsRunner::summarizeRunProfiles(
+		const bib::progutils::CmdArgs & inputCommands) {
+	bfs::path dir = "";
+	std::string profileName = "runProfile.json";
+	seqSetUp setUp(inputCommands);
+	setUp.processVerbose();
+	setUp.setOption(dir, "--dir", "Directory to search for the run profiles written by qluster and processClusters, e.g. an analysis directory from setupTarAmpAnalysis", true);
+	setUp.setOption(profileName, "--profileName", "The file name of the run profiles");
+	setUp.processDirectoryOutputName("runProfileSummary_TODAY", true);
+	setUp.finishSetUp(std::cout);
+
+	auto files = bib::files::listAllFiles(dir.string(), true, {
+			std::regex { "^" + profileName + "$" } });
+	std::vector<bfs::path> profileFnps;
+	for (const auto & f : files) {
+		if (bfs::is_regular_file(f.first)) {
+			profileFnps.emplace_back(f.first);
+		}
+	}
+	if (profileFnps.empty()) {
+		std::stringstream ss;
+		ss << __PRETTY_FUNCTION__ << ", error no files named " << profileName
+				<< " found in " << dir << "\n";
+		throw std::runtime_error { ss.str() };
+	}
+	auto phasesTab = RunPhaseProfiler::genPhasesTable(profileFnps, dir);
+	auto byPhaseTab = RunPhaseProfiler::genByPhaseTable(phasesTab);
+	auto byRunTab = RunPhaseProfiler::genByRunTable(phasesTab);
+	phasesTab.outPutContents(TableIOOpts::genTabFileOut(
+			bib::files::make_path(setUp.pars_.directoryName_, "phases.tab.txt"), true));
+	byPhaseTab.outPutContents(TableIOOpts::genTabFileOut(
+			bib::files::make_path(setUp.pars_.directoryName_, "byPhase.tab.txt"), true));
+	byRunTab.outPutContents(TableIOOpts::genTabFileOut(
+			bib::files::make_path(setUp.pars_.directoryName_, "byRun.tab.txt"), true));
+	if (setUp.pars_.verbose_) {
+		std::cout << "Runs: " << profileFnps.size() << std::endl;
+		byPhaseTab.outPutContentOrganized(std::cout);
+	}
+	return 0;
+}
+
 int SeekDeepUtilsRunner::dryRunQualityFiltering(
 		const bib::progutils::CmdArgs & inputCommands) {
 	seqSetUp setUp(inputCommands);
@@ -406,7 +1015,19 @@ int SeekDeepUtilsRunner::runMultipleCommands(
 	std::string logFile = "";
 	uint32_t numThreads = 1;
 	bool raw = false;
+	bool sizeHints = false;
+	bfs::path previousLog = "";
+	bool resume = false;
+	bool dag = false;
 	setUp.setOption(numThreads, "--numThreads", "Number of threads to use");
+	setUp.setOption(dag, "--dag",
+			"The cmdFile is a json dag of jobs ({\"jobs\":[{\"name\",\"cmd\",\"deps\":[names]}]}), a job starts as soon as the jobs it depends on finish, jobs depending on a failed job are skipped");
+	setUp.setOption(resume, "--resume",
+			"Skip the commands recorded as finished successfully in the ledger next to the cmdFile (cmdFile name + Ledger.tab.txt)");
+	setUp.setOption(sizeHints, "--sizeHints",
+			"Estimate the cost of each command from the size of the files it references and start the largest first, commands with --numThreads N occupy N threads");
+	setUp.setOption(previousLog, "--previousLog",
+			"The json log of a previous run of these commands, run times are used to start the longest commands first");
 	setUp.setOption(logFile, "--logFile",
 			"Name of a file to log the output of the commands");
 	setUp.setOption(filename, "--cmdFile",
@@ -417,6 +1038,11 @@ int SeekDeepUtilsRunner::runMultipleCommands(
 	setUp.processVerbose();
 	setUp.processWritingOptions();
 	setUp.processDebug();
+	if (dag && setUp.pars_.debug_) {
+		//debug runs the commands with runCmdsThreaded which knows nothing of the dependencies
+		setUp.failed_ = true;
+		setUp.addWarning("Error, --debug can't be used with --dag since the commands would be run without waiting on their dependencies");
+	}
 	if (setUp.needsHelp()) {
 		std::cout
 				<< "Input cmdFile should start with CMD: and then command and "
@@ -455,7 +1081,13 @@ int SeekDeepUtilsRunner::runMultipleCommands(
 	std::string cmd;
 	VecStr cmds;
 	std::string line;
-	if (raw) {
+	Json::Value dagJson;
+	if (dag) {
+		dagJson = bib::json::parseFile(filename);
+		for (const auto & job : dagJson["jobs"]) {
+			cmds.emplace_back(job["cmd"].asString());
+		}
+	} else if (raw) {
 		while (bib::files::crossPlatGetline(inFile, line)) {
 			if ("" == line || allWhiteSpaceStr(line) || bib::beginsWith(line, "#")) {
 				continue;
@@ -505,9 +1137,63 @@ int SeekDeepUtilsRunner::runMultipleCommands(
 		printVector(cmds, "\n");
 	}
 
-	auto allRunOutputs = bib::sys::runCmdsThreaded(cmds, numThreads,
-			setUp.pars_.verbose_, setUp.pars_.debug_);
+	std::vector<bib::sys::RunOutput> allRunOutputs;
 	Json::Value allLog;
+	CmdJobScheduler scheduler = dag ?
+					CmdJobScheduler(dagJson, numThreads) :
+					CmdJobScheduler(cmds, numThreads);
+	//the finished commands are removed before scheduling so the predicted makespan only covers what will be run
+	std::unique_ptr<CmdJobLedger> ledger;
+	if (!setUp.pars_.debug_) {
+		auto ledgerFnp = bib::files::make_path(bfs::path(filename).parent_path(),
+				bfs::path(filename).filename().replace_extension("").string()
+						+ "Ledger.tab.txt");
+		ledger = std::make_unique<CmdJobLedger>(ledgerFnp);
+		if (resume) {
+			auto skipped = scheduler.removeFinished(*ledger);
+			std::cout << "Resuming, skipping " << skipped
+					<< " commands already finished according to " << ledgerFnp
+					<< std::endl;
+			allLog["skippedFinished"] = bib::json::toJson(skipped);
+		} else {
+			ledger->logReset();
+		}
+		allLog["ledger"] = bib::json::toJson(bfs::absolute(ledgerFnp));
+	}
+	if (sizeHints || "" != previousLog) {
+		if ("" != previousLog) {
+			auto matched = scheduler.setCostsFromPreviousLog(previousLog);
+			if (setUp.pars_.verbose_) {
+				std::cout << "Found " << matched << " of " << scheduler.jobs_.size()
+						<< " commands in " << previousLog << std::endl;
+			}
+		} else {
+			scheduler.setCostsFromInputSizes();
+		}
+		scheduler.setThreadsFromCmds();
+		auto fileOrderMakespan = scheduler.predictMakespan();
+		scheduler.sortByCost();
+		auto predictedMakespan = scheduler.predictMakespan();
+		std::cout << "Predicted makespan: " << predictedMakespan
+				<< ("" != previousLog ? " seconds" : " bytes")
+				<< ", in file order: " << fileOrderMakespan << std::endl;
+		allLog["schedule"] = scheduler.scheduleJson();
+		allLog["schedule"]["fileOrderMakespan"] = bib::json::toJson(fileOrderMakespan);
+	}
+	if (setUp.pars_.debug_) {
+		allRunOutputs = bib::sys::runCmdsThreaded(cmds, numThreads,
+				setUp.pars_.verbose_, setUp.pars_.debug_);
+	} else {
+		allRunOutputs = scheduler.run(setUp.pars_.verbose_, ledger.get(), !setUp.pars_.verbose_);
+		if (!scheduler.skipped_.empty()) {
+			std::cout << bib::bashCT::boldRed("Skipped " + estd::to_string(scheduler.skipped_.size())
+					+ " commands because a command they depend on failed") << std::endl;
+			auto & skippedLog = allLog["skippedFailedDeps"];
+			for (const auto & index : scheduler.skipped_) {
+				skippedLog.append(cmds[index]);
+			}
+		}
+	}
 
 	allLog["totalTime"] = setUp.timer_.totalTime();
 	allLog["cmdsfile"] = bib::json::toJson(bfs::absolute(filename));
@@ -684,6 +1370,8 @@ int SeekDeepUtilsRunner::setupTarAmpAnalysis(
 			false, "ID Files");
 
 	setUp.setOption(pars.numThreads, "--numThreads", "Number of CPUs to use");
+	setUp.setOption(pars.qlusterNumThreads, "--qlusterNumThreads", "Number of CPUs each qluster command should use");
+	setUp.setOption(pars.sharedAlnCache, "--sharedAlnCache", "Have all the qluster commands for a target share one binary alignment cache (alnCaches/TARGET) rather than each having their own");
 
 	setUp.setOption(pars.extraExtractorCmds, "--extraExtractorCmds",
 			"Extra extractor cmds to add to the defaults", false, "Extra Commands");
@@ -974,6 +1662,23 @@ int SeekDeepUtilsRunner::setupTarAmpAnalysis(
 
 	VecStr extractorCmds;
 	VecStr qlusterCmds;
+	//the threads and the shared alignment cache are set the same way for the by index and by sample qluster templates
+	auto addQlusterRunOpts = [&analysisSetup](std::string & qlusterCmdTemplate){
+		if (analysisSetup.pars_.qlusterNumThreads > 1) {
+			qlusterCmdTemplate += " --numThreads "
+					+ estd::to_string(analysisSetup.pars_.qlusterNumThreads);
+		}
+		if (analysisSetup.pars_.sharedAlnCache) {
+			auto alnCachesDir = bib::files::make_path(bfs::absolute(analysisSetup.dir_), "alnCaches");
+			bib::files::makeDirP(bib::files::MkdirPar(alnCachesDir.string()));
+			qlusterCmdTemplate = bib::replaceString(qlusterCmdTemplate,
+					"--alnInfoDir {TARGET}{MIDREP}_alnCache --overWriteDir ",
+					"--alnCacheArchive \"" + bib::files::make_path(alnCachesDir, "{TARGET}").string() + "\" ");
+		}
+	};
+	//for each qluster cmd the extractor cmd it depends on and its target, used for the analysis dag
+	std::vector<uint32_t> qlusterCmdsExtractorPos;
+	VecStr qlusterCmdsTargets;
 	if (analysisSetup.pars_.byIndex) {
 		if(setUp.pars_.debug_){
 			std::cout << "Samples:" << std::endl;
@@ -1021,6 +1726,7 @@ int SeekDeepUtilsRunner::setupTarAmpAnalysis(
 		} else if (analysisSetup.pars_.techIsIonTorrent()) {
 			qlusterCmdTemplate += "--ionTorrent";
 		}
+		addQlusterRunOpts(qlusterCmdTemplate);
 		auto indexes = analysisSetup.getIndexes();
 		if(setUp.pars_.verbose_){
 			std::cout << "indexes" << std::endl;
@@ -1102,6 +1808,8 @@ int SeekDeepUtilsRunner::setupTarAmpAnalysis(
 						currentQlusterCmdTemplate = bib::replaceString(
 								currentQlusterCmdTemplate, "{MIDREP}", mid);
 						qlusterCmds.emplace_back(currentQlusterCmdTemplate);
+						qlusterCmdsExtractorPos.emplace_back(extractorCmds.size() - 1);
+						qlusterCmdsTargets.emplace_back(tar);
 					}
 				}
 			}
@@ -1149,6 +1857,7 @@ int SeekDeepUtilsRunner::setupTarAmpAnalysis(
 		} else if (analysisSetup.pars_.techIsIonTorrent()) {
 			qlusterCmdTemplate += "--ionTorrent";
 		}
+		addQlusterRunOpts(qlusterCmdTemplate);
 		if(setUp.pars_.debug_){
 			std::cout << "Samples:" << std::endl;
 			std::cout << bib::conToStr(getVectorOfMapKeys(analysisSetup.samples_), "\n") << std::endl;
@@ -1253,6 +1962,8 @@ int SeekDeepUtilsRunner::setupTarAmpAnalysis(
 					currentQlusterCmdTemplate = bib::replaceString(
 							currentQlusterCmdTemplate, "{TARGET}", tar);
 					qlusterCmds.emplace_back(currentQlusterCmdTemplate);
+					qlusterCmdsExtractorPos.emplace_back(extractorCmds.size() - 1);
+					qlusterCmdsTargets.emplace_back(tar);
 				}
 			}
 		}
@@ -1393,11 +2104,11 @@ int SeekDeepUtilsRunner::setupTarAmpAnalysis(
 	runAnalysisFile << "fi" << std::endl;
 	runAnalysisFile << "" << std::endl;
 	runAnalysisFile << "" << setUp.commands_.masterProgram_
-			<< " runMultipleCommands --cmdFile extractorCmds.txt      --numThreads $numThreads --raw"
+			<< " runMultipleCommands --cmdFile extractorCmds.txt      --numThreads $numThreads --raw --sizeHints"
 			<< std::endl;
 	runAnalysisFile << "./combineExtractionCountsCmd.sh"<< std::endl;
 	runAnalysisFile << "" << setUp.commands_.masterProgram_
-			<< " runMultipleCommands --cmdFile qlusterCmds.txt        --numThreads $numThreads --raw"
+			<< " runMultipleCommands --cmdFile qlusterCmds.txt        --numThreads $numThreads --raw --sizeHints"
 			<< std::endl;
 	runAnalysisFile << "" << setUp.commands_.masterProgram_
 			<< " runMultipleCommands --cmdFile processClusterCmds.txt --numThreads $numThreads --raw"
@@ -1410,6 +2121,57 @@ int SeekDeepUtilsRunner::setupTarAmpAnalysis(
 	chmod(runAnalysisOpts.outFilename_.c_str(),
 			S_IWUSR | S_IRUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IEXEC | S_IXGRP);
 
+	//the same analysis as one dag so later steps start as soon as their inputs are done instead of waiting on the slowest job of the step before
+	Json::Value analysisDag;
+	auto & dagJobs = analysisDag["jobs"];
+	VecStr allExtractorNames;
+	for (const auto pos : iter::range(extractorCmds.size())) {
+		allExtractorNames.emplace_back("extractor:" + estd::to_string(pos));
+		dagJobs.append(CmdJobScheduler::genDagJob(allExtractorNames.back(),
+				extractorCmds[pos], VecStr { }));
+	}
+	dagJobs.append(CmdJobScheduler::genDagJob("combineExtractionCounts",
+			"./combineExtractionCountsCmd.sh", allExtractorNames));
+	std::map<std::string, VecStr> qlusterNamesByTarget;
+	for (const auto pos : iter::range(qlusterCmds.size())) {
+		auto name = "qluster:" + estd::to_string(pos);
+		qlusterNamesByTarget[qlusterCmdsTargets[pos]].emplace_back(name);
+		dagJobs.append(CmdJobScheduler::genDagJob(name, qlusterCmds[pos],
+				VecStr { allExtractorNames[qlusterCmdsExtractorPos[pos]] }));
+	}
+	for (const auto pos : iter::range(targets.size())) {
+		dagJobs.append(CmdJobScheduler::genDagJob("processClusters:" + targets[pos],
+				processClusterCmds[pos], qlusterNamesByTarget[targets[pos]]));
+		dagJobs.append(CmdJobScheduler::genDagJob("genConfig:" + targets[pos],
+				genConfigCmds[pos], VecStr { "processClusters:" + targets[pos] }));
+	}
+	OutOptions analysisDagOpts(
+			bib::files::make_path(analysisSetup.dir_, "analysisDag.json"));
+	std::ofstream analysisDagFile;
+	openTextFile(analysisDagFile, analysisDagOpts);
+	analysisDagFile << analysisDag << std::endl;
+
+	OutOptions runAnalysisDagOpts(
+			bib::files::make_path(analysisSetup.dir_, "runAnalysisDag.sh"));
+	std::ofstream runAnalysisDagFile;
+	openTextFile(runAnalysisDagFile, runAnalysisDagOpts);
+	runAnalysisDagFile << "#!/usr/bin/env bash" << std::endl;
+	runAnalysisDagFile << "" << std::endl;
+	runAnalysisDagFile << "##same as runAnalysis.sh but runs all parts as one dag so each step starts as soon as its inputs are done" << std::endl;
+	runAnalysisDagFile << "" << std::endl;
+	runAnalysisDagFile << "numThreads=1" << std::endl;
+	runAnalysisDagFile << "" << std::endl;
+	runAnalysisDagFile << "if [[ $# -eq 1 ]]; then" << std::endl;
+	runAnalysisDagFile << "	numThreads=$1" << std::endl;
+	runAnalysisDagFile << "fi" << std::endl;
+	runAnalysisDagFile << "" << std::endl;
+	runAnalysisDagFile << "" << setUp.commands_.masterProgram_
+			<< " runMultipleCommands --cmdFile analysisDag.json --numThreads $numThreads --dag --sizeHints"
+			<< std::endl;
+	runAnalysisDagFile << "" << std::endl;
+	chmod(runAnalysisDagOpts.outFilename_.c_str(),
+			S_IWUSR | S_IRUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IEXEC | S_IXGRP);
+
 	if (foundErrors) {
 		std::cerr << bib::bashCT::flashing << bib::bashCT::red << bib::bashCT::bold
 				<< "ERRORS FOUND!!" << bib::bashCT::reset << std::endl;
@@ -26,6 +26,7 @@
 //
 //
 #include "SeekDeepUtilsSetUp.hpp"
+#include "FlatKmerIndex.hpp"
 #include "SeekDeep/server.h"
 #include "SeekDeep/objects.h"
 
@@ -43,6 +44,11 @@ class SeekDeepUtilsRunner : public bib::progutils::ProgramRunner {
 
 	static int genTargetInfoFromGenomes(const bib::progutils::CmdArgs & inputCommands);
 
+	static int benchClusterSorting(const bib::progutils::CmdArgs & inputCommands);
+	static int benchEditDistPrefilter(const bib::progutils::CmdArgs & inputCommands);
+	static int benchKmerIndex(const bib::progutils::CmdArgs & inputCommands);
+	static int summarizeRunProfiles(const bib::progutils::CmdArgs & inputCommands);
+
 };
 
 } // namespace bibseq
@@ -0,0 +1,56 @@
+#include <catch.hpp>
+#include "SeekDeep/objects/AlnCacheArchive.hpp"
+
+using namespace bibseq;
+
+namespace {
+
+void addAlignments(aligner & alignerObj, const std::string & prefix, uint32_t num) {
+	for (uint32_t pos = 0; pos < num; ++pos) {
+		alnInfoGlobal info;
+		info.score_ = pos + 1;
+		info.gapInfos_.emplace_back(gapInfo(pos, 1, true));
+		alignerObj.alnHolder_.globalHolder_["test"].infos_[prefix + "A" + estd::to_string(pos)][prefix + "C"] = info;
+	}
+}
+
+}  // namespace
+
+TEST_CASE("Saving after a torn index entry", "[AlnCacheArchive::save]" ){
+	auto dirName = bfs::temp_directory_path() / bfs::unique_path("alnCacheArchive-%%%%-%%%%");
+	AlnCacheArchive archive(dirName, 1024 * 1024 * 1024);
+	auto indexFnp = dirName / "index.bin";
+	auto entrySize = sizeof(AlnCacheArchive::IndexEntry);
+
+	aligner firstAligner;
+	addAlignments(firstAligner, "first", 5);
+	REQUIRE(5 == archive.save(firstAligner));
+	aligner secondAligner;
+	addAlignments(secondAligner, "second", 1);
+	REQUIRE(1 == archive.save(secondAligner));
+
+	SECTION("entries appended after a torn entry are read back"){
+		//as if the process died half way through appending the last entry
+		auto fullSize = bfs::file_size(indexFnp);
+		bfs::resize_file(indexFnp, fullSize - entrySize / 2);
+
+		aligner thirdAligner;
+		addAlignments(thirdAligner, "third", 3);
+		REQUIRE(3 == archive.save(thirdAligner));
+		REQUIRE(fullSize - entrySize + 3 * entrySize == bfs::file_size(indexFnp));
+
+		AlnCacheArchive reopened(dirName, 1024 * 1024 * 1024);
+		aligner loadedAligner;
+		REQUIRE(8 == reopened.load(loadedAligner, std::unordered_set<std::string>{}));
+		auto & infos = loadedAligner.alnHolder_.globalHolder_["test"].infos_;
+		for (const auto & prefix : VecStr{"first", "third"}) {
+			for (uint32_t pos = 0; pos < ("first" == prefix ? 5 : 3); ++pos) {
+				const auto & info = infos[prefix + "A" + estd::to_string(pos)][prefix + "C"];
+				REQUIRE(pos + 1 == info.score_);
+				REQUIRE(pos == info.gapInfos_.front().pos_);
+			}
+		}
+		REQUIRE(0 == infos.count("secondA0"));
+	}
+	bfs::remove_all(dirName);
+}
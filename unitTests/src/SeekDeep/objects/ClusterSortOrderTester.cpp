@@ -0,0 +1,80 @@
+#include <catch.hpp>
+#include "SeekDeep/objects/ClusterSortOrder.hpp"
+
+using namespace bibseq;
+
+namespace {
+struct TestRead {
+	struct {
+		std::string name_;
+		double cnt_;
+		double frac_;
+	} seqBase_;
+	TestRead(const std::string & name, double cnt, double frac) :
+			seqBase_ { name, cnt, frac } {
+	}
+};
+
+std::vector<uint32_t> genExpectedOrder(const std::vector<TestRead> & reads,
+		const std::vector<bool> & removed) {
+	std::vector<uint32_t> ret;
+	for (const auto pos : ClusterSortOrder::genTotalCountOrder(reads)) {
+		if (!removed[pos]) {
+			ret.emplace_back(pos);
+		}
+	}
+	return ret;
+}
+}  // namespace
+
+TEST_CASE("Incremental count order follows the total count order", "[IncrementalCountOrder::getOrder]" ){
+	std::vector<TestRead> reads{
+		TestRead("d", 5, 0.1),
+		TestRead("c", 5, 0.2),
+		TestRead("b", 5, 0.1),
+		TestRead("a", 10, 0.1),
+		TestRead("e", 1, 0.1),
+		TestRead("f", 3, 0.1)};
+	std::vector<bool> removed(reads.size(), false);
+	IncrementalCountOrder countOrder(reads);
+
+	SECTION("ties are broken by fraction then name rather than position"){
+		REQUIRE(std::vector<uint32_t>{3, 1, 2, 0, 5, 4} == countOrder.getOrder());
+	}
+	SECTION("removes and count changes are applied in one go"){
+		const auto & order = countOrder.getOrder();
+		reads[0].seqBase_.cnt_ += reads[4].seqBase_.cnt_;
+		removed[4] = true;
+		countOrder.remove(4);
+		countOrder.setCount(0, reads[0].seqBase_.cnt_);
+		reads[5].seqBase_.cnt_ += reads[2].seqBase_.cnt_;
+		reads[5].seqBase_.frac_ = 0.3;
+		removed[2] = true;
+		countOrder.remove(2);
+		countOrder.setCount(5, reads[5].seqBase_.cnt_);
+		//nothing moves until the order is asked for
+		REQUIRE(6 == order.size());
+		REQUIRE(4 == countOrder.size());
+		countOrder.getOrder();
+		REQUIRE(genExpectedOrder(reads, removed) == order);
+		REQUIRE(std::vector<uint32_t>{3, 5, 0, 1} == order);
+	}
+	SECTION("a count set to the same value is still re-sorted on its new tie break"){
+		reads[2].seqBase_.frac_ = 0.5;
+		countOrder.setCount(2, reads[2].seqBase_.cnt_);
+		REQUIRE(std::vector<uint32_t>{3, 2, 1, 0, 5, 4} == countOrder.getOrder());
+	}
+	SECTION("removed positions can't be changed again"){
+		countOrder.remove(1);
+		REQUIRE_THROWS(countOrder.setCount(1, 20));
+		REQUIRE_THROWS(countOrder.remove(1));
+		REQUIRE_THROWS(countOrder.remove(6));
+	}
+}
+
+TEST_CASE("Incremental count order from counts alone", "[IncrementalCountOrder::IncrementalCountOrder]" ){
+	IncrementalCountOrder countOrder(std::vector<double>{2, 4, 2, 1});
+	REQUIRE(std::vector<uint32_t>{1, 0, 2, 3} == countOrder.getOrder());
+	countOrder.setCount(3, 4);
+	REQUIRE(std::vector<uint32_t>{1, 3, 0, 2} == countOrder.getOrder());
+}
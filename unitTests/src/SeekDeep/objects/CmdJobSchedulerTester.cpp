@@ -0,0 +1,89 @@
+#include <catch.hpp>
+#include "SeekDeep/objects/CmdJobScheduler.hpp"
+
+using namespace bibseq;
+
+TEST_CASE("Resuming commands that contain newlines", "[CmdJobScheduler::removeFinished]" ){
+	auto ledgerFnp = bfs::temp_directory_path() / bfs::unique_path("cmdJobLedger-%%%%-%%%%.tab.txt");
+	VecStr cmds{"echo one", "echo two\necho three", "echo 'a\\nb'\r\necho four", "echo five"};
+
+	SECTION("commands are escaped onto one line and read back as is"){
+		for (const auto & cmd : cmds) {
+			REQUIRE(std::string::npos == CmdJobLedger::escapeCmd(cmd).find('\n'));
+			REQUIRE(cmd == CmdJobLedger::unescapeCmd(CmdJobLedger::escapeCmd(cmd)));
+		}
+	}
+	SECTION("finished commands with newlines aren't run again"){
+		{
+			CmdJobLedger ledger(ledgerFnp);
+			ledger.logReset();
+			bib::sys::RunOutput success;
+			success.returnCode_ = 0;
+			bib::sys::RunOutput failure;
+			failure.returnCode_ = 1;
+			ledger.logFinish(0, cmds[0], success);
+			ledger.logFinish(1, cmds[1], success);
+			ledger.logFinish(2, cmds[2], success);
+			ledger.logFinish(3, cmds[3], failure);
+		}
+		CmdJobLedger ledger(ledgerFnp);
+		CmdJobScheduler scheduler(cmds, 2);
+		REQUIRE(3 == scheduler.removeFinished(ledger));
+		REQUIRE(1 == scheduler.jobs_.size());
+		REQUIRE(cmds[3] == scheduler.jobs_.front().cmd_);
+	}
+	bfs::remove(ledgerFnp);
+}
+
+TEST_CASE("Costs of dag jobs whose inputs don't exist yet", "[CmdJobScheduler::setCostsFromInputSizes]" ){
+	auto inputFnp = bfs::temp_directory_path() / bfs::unique_path("cmdJobInput-%%%%-%%%%.fastq");
+	{
+		std::ofstream inputFile(inputFnp.string());
+		inputFile << std::string(1000, 'A');
+	}
+	auto missingFnp = bfs::temp_directory_path() / bfs::unique_path("cmdJobMissing-%%%%-%%%%.fastq");
+	Json::Value dagJson;
+	dagJson["jobs"].append(CmdJobScheduler::genDagJob("extract", "extract " + inputFnp.string(), VecStr{}));
+	dagJson["jobs"].append(CmdJobScheduler::genDagJob("qluster1", "qluster " + missingFnp.string(), VecStr{"extract"}));
+	dagJson["jobs"].append(CmdJobScheduler::genDagJob("qluster2", "qluster " + missingFnp.string(), VecStr{"extract"}));
+	dagJson["jobs"].append(CmdJobScheduler::genDagJob("processClusters", "processClusters", VecStr{"qluster1", "qluster2"}));
+	dagJson["jobs"].append(CmdJobScheduler::genDagJob("small", "small", VecStr{}));
+	CmdJobScheduler scheduler(dagJson, 2);
+	scheduler.setCostsFromInputSizes();
+	std::unordered_map<std::string, double> costs;
+	for (const auto & job : scheduler.jobs_) {
+		costs[job.name_] = job.cost_;
+	}
+	REQUIRE(1000 == costs["extract"]);
+	REQUIRE(500 == costs["qluster1"]);
+	REQUIRE(500 == costs["qluster2"]);
+	REQUIRE(1000 == costs["processClusters"]);
+	REQUIRE(0 == costs["small"]);
+	bfs::remove(inputFnp);
+}
+
+TEST_CASE("Resuming a dag whose finished job comes after the jobs depending on it", "[CmdJobScheduler::run]" ){
+	auto ledgerFnp = bfs::temp_directory_path() / bfs::unique_path("cmdJobLedger-%%%%-%%%%.tab.txt");
+	//names are resolved once every job is read so a job can depend on one listed after it
+	Json::Value dagJson;
+	dagJson["jobs"].append(CmdJobScheduler::genDagJob("processClusters", "true processClusters", VecStr{"qluster"}));
+	dagJson["jobs"].append(CmdJobScheduler::genDagJob("qluster", "true qluster", VecStr{}));
+	{
+		CmdJobLedger ledger(ledgerFnp);
+		ledger.logReset();
+		bib::sys::RunOutput success;
+		success.returnCode_ = 0;
+		ledger.logFinish(1, "true qluster", success);
+	}
+	CmdJobLedger ledger(ledgerFnp);
+	CmdJobScheduler scheduler(dagJson, 2);
+	REQUIRE(1 == scheduler.removeFinished(ledger));
+	REQUIRE(1 == scheduler.jobs_.size());
+	scheduler.jobs_.front().cost_ = 5;
+	REQUIRE(5 == scheduler.predictMakespan());
+	auto outs = scheduler.run(false);
+	REQUIRE(1 == outs.size());
+	REQUIRE(outs.front().success_);
+	REQUIRE(scheduler.skipped_.empty());
+	bfs::remove(ledgerFnp);
+}
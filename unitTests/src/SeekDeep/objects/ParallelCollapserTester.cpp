@@ -0,0 +1,40 @@
+#include <catch.hpp>
+#include "SeekDeep/objects/ParallelCollapser.hpp"
+
+using namespace bibseq;
+
+TEST_CASE("K-mer profiles of reads with ambiguous bases", "[ParallelCollapser::kmersRuleOut]" ){
+	const uint32_t kLen = 4;
+	const std::string ref = "ACGTTGCAAGCTTCGATCGA";
+	//one mismatch changes at most kLen k-mers
+	const uint32_t maxChangedKmers = kLen;
+	const uint32_t maxLenDiff = 0;
+
+	SECTION("reads with only ACGT are still ruled out by shared k-mers"){
+		auto refProfile = ParallelCollapser::genKmerProfile(ref, kLen);
+		auto far = ParallelCollapser::genKmerProfile("ACGTTCCAAGGTTCCATCGA", kLen);
+		auto near = ParallelCollapser::genKmerProfile("ACGTTGCAAGGTTCGATCGA", kLen);
+		REQUIRE_FALSE(refProfile.ambiguous_);
+		REQUIRE(ParallelCollapser::kmersRuleOut(refProfile, far, maxChangedKmers, maxLenDiff));
+		REQUIRE_FALSE(ParallelCollapser::kmersRuleOut(refProfile, near, maxChangedKmers, maxLenDiff));
+	}
+	SECTION("a read with Ns the aligner could match isn't ruled out on k-mers"){
+		//the two Ns knock out more k-mers than one mismatch would but the aligner can score them as matches
+		const std::string withNs = "ACGTTNCAAGCTNCGATCGA";
+		auto refProfile = ParallelCollapser::genKmerProfile(ref, kLen);
+		auto nProfile = ParallelCollapser::genKmerProfile(withNs, kLen);
+		REQUIRE(nProfile.ambiguous_);
+		REQUIRE(ParallelCollapser::hasAmbiguousBases(withNs));
+		REQUIRE_FALSE(ParallelCollapser::hasAmbiguousBases(ref));
+		auto mostKmers = std::max(refProfile.kmers_.size(), nProfile.kmers_.size());
+		REQUIRE(ParallelCollapser::sharedKmers(refProfile, nProfile) < mostKmers - maxChangedKmers);
+		REQUIRE_FALSE(ParallelCollapser::kmersRuleOut(refProfile, nProfile, maxChangedKmers, maxLenDiff));
+		REQUIRE_FALSE(ParallelCollapser::kmersRuleOut(nProfile, refProfile, maxChangedKmers, maxLenDiff));
+	}
+	SECTION("a read with Ns is still ruled out on length"){
+		auto refProfile = ParallelCollapser::genKmerProfile(ref, kLen);
+		auto nProfile = ParallelCollapser::genKmerProfile("ACGTTNCAAGCTNCGATCGAAA", kLen);
+		REQUIRE(ParallelCollapser::kmersRuleOut(refProfile, nProfile, maxChangedKmers, maxLenDiff));
+		REQUIRE_FALSE(ParallelCollapser::kmersRuleOut(refProfile, nProfile, maxChangedKmers, 2));
+	}
+}
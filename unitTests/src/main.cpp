@@ -0,0 +1,7 @@
+
+// based off https://github.com/philsquared/Catch/blob/master/docs/tutorial.md
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main()
+#include <catch.hpp>
+
+    